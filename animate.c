@@ -0,0 +1,355 @@
+#include <inttypes.h>
+#include <pthread.h>
+#include <quadmath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "animate.h"
+#include "timer.h"
+
+// Maximale Größe der Pixeldaten eines Bildes in Byte (4 GiB). Anders als bei
+// einzelnen Bildern werden die Iterationszähler einer Animation vollständig im
+// Speicher gehalten
+#define MAX_FRAME_SIZE (1ULL << 32)
+
+// Thread, der fertig berechnete Bilder einfärbt und schreibt, während bereits das
+// nächste Bild berechnet wird
+struct encoder
+{
+        pthread_t thread;
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+        const uint16_t *counts; // Zu schreibendes Bild, NULL: keines
+        uint64_t frame;
+        _Bool stop;
+        _Bool failed;
+
+        const char *file_name;
+        image_format format;
+        uint64_t width;
+        uint64_t height;
+        uint64_t strip_height;
+        const palette_scheme *schemes;
+        palette *palettes[PALETTE_COUNT];
+        unsigned palette_count;
+};
+
+// check_view: Prüft, ob ein Ausschnitt im erlaubten Bereich liegt und eine positive
+// Breite und Höhe hat. Gibt sonst eine Fehlermeldung aus
+static _Bool check_view(hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end)
+{
+        if (r_start < -2 || r_start > 1 || r_end < -2 || r_end > 1)
+        {
+                fprintf(stderr, "   Die Eingaben für r_start und r_end müssen im Interval [-2;1] liegen.\r\n");
+                fflush(stderr);
+                return 0;
+        }
+        if (i_start < -1 || i_start > 1 || i_end < -1 || i_end > 1)
+        {
+                fprintf(stderr, "   Die Eingaben für i_start und i_end müssen im Interval [-1;1] liegen.\r\n");
+                fflush(stderr);
+                return 0;
+        }
+        if (r_end <= r_start || i_end <= i_start)
+        {
+                fprintf(stderr, "   Mit den eingegebenen Parametern kann keine Berechnung durchgeführt werden.\r\n");
+                fflush(stderr);
+                return 0;
+        }
+        return 1;
+}
+
+// encode_frame: Färbt ein Bild mit jedem Farbschema ein und schreibt es. Die erste
+// Datei heißt file_name_0000, weitere tragen zusätzlich den Namen ihres Schemas
+static _Bool encode_frame(struct encoder *encoder, const uint16_t *counts, uint64_t frame)
+{
+        const char *extension = image_format_extension(encoder->format);
+        char path[strlen(encoder->file_name) + 48];
+        for (unsigned p = 0; p < encoder->palette_count; p++)
+        {
+                if (p == 0)
+                        snprintf(path, sizeof(path), "%s_%04" PRIu64 "%s", encoder->file_name, frame, extension);
+                else
+                        snprintf(path, sizeof(path), "%s_%s_%04" PRIu64 "%s", encoder->file_name,
+                                 palette_name(encoder->schemes[p]), frame, extension);
+
+                // Ohne Threadpool, da dieser während des Schreibens das nächste Bild berechnet
+                image_writer_settings settings = {.rows_per_strip = encoder->strip_height};
+                settings.colors = palette_colors(encoder->palettes[p], &settings.color_count);
+                image_writer *writer = image_writer_open(path, encoder->format, encoder->width, encoder->height,
+                                                         &settings);
+                if (writer == NULL)
+                {
+                        fprintf(stderr, "   Die Datei %s konnte nicht erstellt werden.\r\n", path);
+                        fflush(stderr);
+                        return 0;
+                }
+
+                ptrdiff_t stride;
+                unsigned char *pixels = image_writer_rows(writer, 0, encoder->height, &stride);
+                _Bool written = pixels != NULL;
+                if (written && image_format_indexed(encoder->format))
+                        palette_index_rows(encoder->palettes[p], counts, encoder->width, pixels, stride, encoder->width,
+                                           encoder->height);
+                else if (written)
+                        palette_apply_rows(encoder->palettes[p], counts, encoder->width, pixels, stride, encoder->width,
+                                           encoder->height);
+                if (!image_writer_close(writer) || !written)
+                {
+                        fprintf(stderr, "   Die Datei %s konnte nicht geschrieben werden.\r\n", path);
+                        fflush(stderr);
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+// Startpunkt des Encoder Threads: Wartet auf ein Bild, schreibt es und meldet die
+// Fertigstellung, bis encoder_stop aufgerufen wird
+static void *encoder_main(void *arg)
+{
+        struct encoder *encoder = arg;
+        pthread_mutex_lock(&encoder->lock);
+        for (;;)
+        {
+                while (encoder->counts == NULL && !encoder->stop)
+                        pthread_cond_wait(&encoder->changed, &encoder->lock);
+                if (encoder->counts == NULL)
+                        break;
+
+                const uint16_t *counts = encoder->counts;
+                uint64_t frame = encoder->frame;
+                pthread_mutex_unlock(&encoder->lock);
+                _Bool written = encode_frame(encoder, counts, frame);
+                pthread_mutex_lock(&encoder->lock);
+
+                encoder->failed = encoder->failed || !written;
+                encoder->counts = NULL;
+                pthread_cond_broadcast(&encoder->changed);
+        }
+        pthread_mutex_unlock(&encoder->lock);
+        return NULL;
+}
+
+// encoder_submit: Wartet, bis das vorherige Bild geschrieben ist, und übergibt das
+// nächste. Dessen Zähler dürfen bis zum nächsten Aufruf nicht verändert werden.
+// Gibt 0 zurück, falls ein Bild nicht geschrieben werden konnte
+static _Bool encoder_submit(struct encoder *encoder, const uint16_t *counts, uint64_t frame)
+{
+        pthread_mutex_lock(&encoder->lock);
+        while (encoder->counts != NULL)
+                pthread_cond_wait(&encoder->changed, &encoder->lock);
+        if (!encoder->failed)
+        {
+                encoder->counts = counts;
+                encoder->frame = frame;
+                pthread_cond_broadcast(&encoder->changed);
+        }
+        _Bool failed = encoder->failed;
+        pthread_mutex_unlock(&encoder->lock);
+        return !failed;
+}
+
+// encoder_stop: Wartet, bis das letzte Bild geschrieben ist, und beendet den Thread.
+// Gibt 0 zurück, falls ein Bild nicht geschrieben werden konnte
+static _Bool encoder_stop(struct encoder *encoder)
+{
+        pthread_mutex_lock(&encoder->lock);
+        encoder->stop = 1;
+        pthread_cond_broadcast(&encoder->changed);
+        pthread_mutex_unlock(&encoder->lock);
+        pthread_join(encoder->thread, NULL);
+        return !encoder->failed;
+}
+
+int animate(const char *file_name, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end, double resolution,
+            int16_t max_iterations, const render_options *options, const animation_settings *settings, uint64_t *reused_tiles)
+{
+        if (resolution <= 0)
+        {
+                fprintf(stderr, "   Die Resolution darf nicht negativ oder 0 sein.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        if (max_iterations < 0)
+        {
+                fprintf(stderr, "   Die Anzahl der maximalen Iterationen darf nicht kleiner 0 sein.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        if (!settings->has_end)
+        {
+                fprintf(stderr, "   Für die Animation muss mit --to ein Endausschnitt angegeben werden.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        if (settings->frames == 0)
+        {
+                fprintf(stderr, "   Die Anzahl der Bilder muss größer 0 sein.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        if (!check_view(r_start, r_end, i_start, i_end) ||
+            !check_view(settings->r_start, settings->r_end, settings->i_start, settings->i_end))
+                return EXIT_FAILURE;
+
+        // Alle Bilder haben die Größe des Startausschnitts
+        precision_tier precision = precision_resolve(options->precision, r_start, r_end, i_start, i_end, resolution);
+        uint64_t width = render_dimension(r_start, r_end, resolution, precision);
+        uint64_t height = render_dimension(i_start, i_end, resolution, precision);
+        if (width == 0 || height == 0 || width > MAX_FRAME_SIZE / 3 / height)
+        {
+                fprintf(stderr, "   Mit den eingegebenen Parametern kann keine Berechnung durchgeführt werden.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        image_format format = image_format_resolve(options->format, width, height);
+        if (format == IMAGE_FORMAT_AUTO)
+        {
+                fprintf(stderr, "   Das Bild ist für das gewählte Dateiformat zu groß.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        kernel_variant kernel = kernel_resolve(options->kernel);
+        if (!kernel_supported(kernel))
+        {
+                fprintf(stderr, "   Der Kernel %s wird von diesem Prozessor nicht unterstützt.\r\n", kernel_name(kernel));
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        // Zwei Puffer für die Iterationszähler: In einen wird berechnet, während der
+        // Encoder den anderen einfärbt und schreibt
+        struct encoder encoder = {
+            .file_name = file_name,
+            .format = format,
+            .width = width,
+            .height = height,
+            .strip_height = options->strip_height == 0 || options->strip_height > height ? height : options->strip_height,
+            .schemes = options->palettes,
+            .palette_count = options->palette_count,
+        };
+        uint16_t *counts[2] = {malloc(width * height * sizeof(uint16_t)), malloc(width * height * sizeof(uint16_t))};
+        threadpool *pool = threadpool_create(options->threads);
+        _Bool allocated = counts[0] != NULL && counts[1] != NULL && pool != NULL;
+        for (unsigned p = 0; p < encoder.palette_count; p++)
+        {
+                encoder.palettes[p] = palette_create(options->palettes[p], max_iterations, image_format_rgb(format));
+                allocated = allocated && encoder.palettes[p] != NULL;
+        }
+        pthread_mutex_init(&encoder.lock, NULL);
+        pthread_cond_init(&encoder.changed, NULL);
+        _Bool started = allocated && !pthread_create(&encoder.thread, NULL, encoder_main, &encoder);
+        if (!started)
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+        }
+
+        // Die Breite des Ausschnitts ändert sich pro Bild um denselben Faktor. Der
+        // Mittelpunkt bewegt sich im selben Verhältnis wie die Breite, sodass der
+        // Endausschnitt gleichmäßig näher kommt. Ohne Zoom bewegt er sich linear.
+        // Vom Endausschnitt werden nur Mittelpunkt und Breite verwendet
+        // Ohne Zoom werden alle Bilder auf das Raster des Ausschnitts ausgerichtet, der am
+        // Ursprung von Start- oder Endbild beginnt. Um ganze Pixel verschobene Bilder
+        // berechnen gemeinsame Pixel so mit denselben Koordinaten, unabhängig von --reuse.
+        // Als Verschiebung gilt, wenn sich die Breite um weniger als 0x1p-10 Pixel ändert,
+        // wie in render_plan_align, sodass Rundungsfehler der Eingabe keinen Zoom ergeben
+        _Bool pan = fabsq((settings->r_end - settings->r_start) - (r_end - r_start)) / resolution < 0x1p-10Q;
+        hp_float end_ratio = pan ? 1 : (settings->r_end - settings->r_start) / (r_end - r_start);
+        hp_float center_r = (r_start + r_end) / 2;
+        hp_float center_i = (i_start + i_end) / 2;
+        hp_float end_center_r = (settings->r_start + settings->r_end) / 2;
+        hp_float end_center_i = (settings->i_start + settings->i_end) / 2;
+
+        hp_float end_r_start = end_center_r - (r_end - r_start) / 2;
+        hp_float end_i_start = end_center_i - (i_end - i_start) / 2;
+        render_view grid = {
+            .r_start = end_r_start < r_start ? end_r_start : r_start,
+            .i_start = end_i_start < i_start ? end_i_start : i_start,
+            .resolution = resolution,
+        };
+
+        render_plan *previous = NULL;
+        uint64_t frame_tiles = ((width + options->tile_size - 1) / options->tile_size) *
+                               ((height + options->tile_size - 1) / options->tile_size);
+        uint64_t reused = 0;
+        uint64_t frames = 0;
+        double compute_time = 0;
+        double start = curtime();
+        _Bool failed = !started;
+        for (uint64_t frame = 0; frame < settings->frames && !failed; frame++)
+        {
+                hp_float t = settings->frames > 1 ? (hp_float)frame / (hp_float)(settings->frames - 1) : 0;
+                hp_float ratio = powq(end_ratio, t);
+                hp_float progress = !pan ? (1 - ratio) / (1 - end_ratio) : t;
+                render_view view = {
+                    .resolution = (double)(resolution * ratio),
+                    .max_iterations = max_iterations,
+                    .width = width,
+                    .height = height,
+                };
+                view.r_start = center_r + (end_center_r - center_r) * progress - (r_end - r_start) * ratio / 2;
+                view.i_start = center_i + (end_center_i - center_i) * progress - (i_end - i_start) * ratio / 2;
+
+                // Die Genauigkeitsstufe wird pro Bild gewählt, tiefe Zooms wechseln
+                // daher unterwegs von float über double zur Störungsrechnung
+                precision_tier frame_precision = precision_resolve(options->precision, view.r_start,
+                                                                   view.r_start + (hp_float)width * view.resolution,
+                                                                   view.i_start,
+                                                                   view.i_start + (hp_float)height * view.resolution,
+                                                                   view.resolution);
+                render_plan *plan = render_plan_create(&view, kernel, options->lanes, frame_precision);
+                if (plan == NULL)
+                {
+                        fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                        fflush(stderr);
+                        failed = 1;
+                        break;
+                }
+
+                if (pan)
+                        render_plan_align(plan, &grid);
+
+                double begin = curtime();
+                reused += render_plan_reuse(pool, plan, settings->reuse ? previous : NULL, counts[(frame + 1) % 2],
+                                            counts[frame % 2], options->tile_size, options->mode, settings->fill);
+                compute_time += curtime() - begin;
+
+                render_plan_destroy(previous);
+                previous = plan;
+                failed = !encoder_submit(&encoder, counts[frame % 2], frame);
+                frames += !failed;
+        }
+        render_plan_destroy(previous);
+        if (started)
+                failed = !encoder_stop(&encoder) || failed;
+        double total_time = curtime() - start;
+
+        threadpool_destroy(pool);
+        pthread_mutex_destroy(&encoder.lock);
+        pthread_cond_destroy(&encoder.changed);
+        for (unsigned p = 0; p < encoder.palette_count; p++)
+                palette_destroy(encoder.palettes[p]);
+        free(counts[0]);
+        free(counts[1]);
+        if (failed)
+                return EXIT_FAILURE;
+
+        printf("   %" PRIu64 " Bilder wurden in %f Sekunden erzeugt, davon %f Sekunden Berechnung (%u Threads, Kernel %s, Modus %s).\r\n",
+               frames, total_time, compute_time, options->threads, kernel_name(kernel), render_mode_name(options->mode));
+        printf("   %" PRIu64 " von %" PRIu64 " Kacheln wurden aus dem jeweils vorherigen Bild übernommen.\r\n",
+               reused, frames * frame_tiles);
+        if (reused_tiles != NULL)
+                *reused_tiles = reused;
+        printf("   Bilder \"%s_0000%s\" bis \"%s_%04" PRIu64 "%s\" wurden erfolgreich erzeugt.\r\n",
+               file_name, image_format_extension(format), file_name, frames - 1, image_format_extension(format));
+        fflush(stdout);
+        return EXIT_SUCCESS;
+}
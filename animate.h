@@ -0,0 +1,28 @@
+// Include Guards
+#ifndef ANIMATE_H
+#define ANIMATE_H
+#include "render.h"
+
+// Einstellungen einer Zoomanimation
+typedef struct
+{
+        uint64_t frames;   // Anzahl der Bilder inklusive Start- und Endausschnitt
+        hp_float r_start;  // Endausschnitt
+        hp_float r_end;
+        hp_float i_start;
+        hp_float i_end;
+        _Bool has_end;     // Gibt an, ob ein Endausschnitt angegeben wurde
+        _Bool reuse;       // Übernahme von Kacheln aus dem vorherigen Bild
+        _Bool fill;        // Verlustbehaftetes Füllen einheitlicher Kacheln beim Zoomen
+} animation_settings;
+
+// animate: Berechnet frames Bilder vom Startausschnitt zum Endausschnitt der
+// Einstellungen und schreibt sie als file_name_0000 usw. Alle Bilder haben die
+// Größe des Startausschnitts, die Breite des sichtbaren Bereichs ändert sich
+// geometrisch. Ein Bild wird berechnet, während ein eigener Thread das vorherige
+// einfärbt und schreibt. Die Anzahl der übernommenen Kacheln wird in reused_tiles
+// gespeichert (NULL: keine Rückgabe). Gibt EXIT_SUCCESS oder EXIT_FAILURE zurück
+int animate(const char *file_name, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end, double resolution,
+            int16_t max_iterations, const render_options *options, const animation_settings *settings, uint64_t *reused_tiles);
+
+#endif // !ANIMATE_H
@@ -0,0 +1,197 @@
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "context.h"
+#include "deepzoom.h"
+#include "timer.h"
+
+// Maximale Länge einer Zeile der Eingabe inklusive Zeilenumbruch
+#define LINE_SIZE 4096
+
+// Anzahl der Felder eines Auftrags
+#define JOB_FIELDS 7
+
+struct batch
+{
+        // Die Eingabe wird nur von einem Thread gleichzeitig gelesen. line zählt die
+        // gelesenen Zeilen und nummeriert so die Aufträge
+        pthread_mutex_t input_lock;
+        FILE *input;
+        uint64_t line;
+
+        // Atomar gezählt
+        uint64_t jobs;
+        uint64_t failed;
+};
+
+// Thread eines gleichzeitig berechneten Auftrags mit eigenem Rechenkontext
+struct batch_worker
+{
+        pthread_t thread;
+        struct batch *batch;
+        render_context *context;
+        _Bool started;
+};
+
+// read_line: Liest die nächste Zeile der Eingabe nach line und setzt *number auf ihre
+// Nummer. Der Rest zu langer Zeilen wird verworfen und die Zeile durch eine leere
+// ersetzt, damit sie als fehlerhaft gemeldet wird. Gibt 0 am Ende der Eingabe zurück
+static _Bool read_line(struct batch *batch, char *line, uint64_t *number)
+{
+        pthread_mutex_lock(&batch->input_lock);
+        _Bool read = fgets(line, LINE_SIZE, batch->input) != NULL;
+        if (read && strchr(line, '\n') == NULL && !feof(batch->input))
+        {
+                int c;
+                while ((c = fgetc(batch->input)) != EOF && c != '\n')
+                        ;
+                line[0] = '\0';
+        }
+        *number = ++batch->line;
+        pthread_mutex_unlock(&batch->input_lock);
+        return read;
+}
+
+// run_job: Berechnet den Auftrag einer Zeile und gibt sein Ergebnis aus
+static void run_job(struct batch *batch, render_context *context, char *line, uint64_t number)
+{
+        // Leerzeilen und Kommentare
+        char *fields[JOB_FIELDS + 1];
+        unsigned count = 0;
+        char *state;
+        for (char *field = strtok_r(line, " \t\r\n", &state); field != NULL && count <= JOB_FIELDS;
+             field = strtok_r(NULL, " \t\r\n", &state))
+                fields[count++] = field;
+        if (count == 0 || fields[0][0] == '#')
+                return;
+
+        __atomic_fetch_add(&batch->jobs, 1, __ATOMIC_RELAXED);
+        if (count != JOB_FIELDS)
+        {
+                __atomic_fetch_add(&batch->failed, 1, __ATOMIC_RELAXED);
+                printf("   Auftrag in Zeile %" PRIu64 ": Bitte halten sie sich an das Format 'dateiname r_start r_end i_start i_end resolution i_max'\r\n",
+                       number);
+                fflush(stdout);
+                return;
+        }
+
+        render_request request = {
+            .r_start = hp_parse(fields[1]),
+            .r_end = hp_parse(fields[2]),
+            .i_start = hp_parse(fields[3]),
+            .i_end = hp_parse(fields[4]),
+            .resolution = atof(fields[5]),
+            .max_iterations = (float)atof(fields[6]),
+            .sink = {.file_name = fields[0]},
+        };
+        render_result result;
+        double start = curtime();
+        render_status status = render_context_run(context, &request, &result);
+        double time = curtime() - start;
+        if (status != RENDER_OK)
+        {
+                __atomic_fetch_add(&batch->failed, 1, __ATOMIC_RELAXED);
+                printf("   Auftrag in Zeile %" PRIu64 ": %s\r\n", number, render_context_error(context));
+                fflush(stdout);
+                return;
+        }
+
+        // Abweichungen von der Referenz werden gemeldet, machen den Auftrag aber
+        // wie bei einzelnen Bildern nicht ungültig
+        char verified[96] = "";
+        if (result.verified)
+                snprintf(verified, sizeof(verified), ", %" PRIu64 " von %" PRIu64 " geprüften Pixeln abweichend",
+                         result.mismatches, result.compared_rows * result.width);
+        printf("   Auftrag in Zeile %" PRIu64 ": \"%s\" in %f Sekunden (Berechnung %f Sekunden, %" PRIu64 "x%" PRIu64 " Pixel, Genauigkeit %s%s).\r\n",
+               number, result.paths[0], time, result.time, result.width, result.height,
+               precision_name(result.precision), verified);
+        fflush(stdout);
+}
+
+// batch_main: Berechnet Aufträge, bis die Eingabe erschöpft ist
+static void *batch_main(void *arg)
+{
+        struct batch_worker *worker = arg;
+        char line[LINE_SIZE];
+        uint64_t number;
+        while (read_line(worker->batch, line, &number))
+                run_job(worker->batch, worker->context, line, number);
+        return NULL;
+}
+
+int batch(const render_options *options, const batch_settings *settings)
+{
+        // Der Kachel-Cache darf nur von einem Kontext gleichzeitig verwendet werden
+        unsigned jobs = settings->jobs > 0 ? settings->jobs : options->threads;
+        if (options->cache_path != NULL && jobs > 1)
+        {
+                fprintf(stderr, "   Der Kachel-Cache ist im Batch-Modus nur mit --jobs=1 möglich.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        _Bool standard_input = settings->input == NULL || !strcmp(settings->input, "-");
+        FILE *input = standard_input ? stdin : fopen(settings->input, "r");
+        if (input == NULL)
+        {
+                fprintf(stderr, "   Die Datei %s konnte nicht geöffnet werden.\r\n", settings->input);
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        // Die Threads werden gleichmäßig auf die Aufträge verteilt. Die Zeitkarte
+        // des Stats-Modus würde jeder Auftrag überschreiben
+        render_options job_options = *options;
+        job_options.threads = options->threads / jobs > 0 ? options->threads / jobs : 1;
+        job_options.stats_path = NULL;
+
+        struct batch state = {.input = input};
+        pthread_mutex_init(&state.input_lock, NULL);
+        struct batch_worker *workers = calloc(jobs, sizeof(*workers));
+        _Bool allocated = workers != NULL;
+        for (unsigned w = 0; w < jobs && allocated; w++)
+        {
+                workers[w].batch = &state;
+                workers[w].context = render_context_create(&job_options);
+                allocated = workers[w].context != NULL;
+        }
+
+        double start = curtime();
+        if (allocated)
+        {
+                printf("   Batch mit %u gleichzeitigen Aufträgen zu je %u Threads.\r\n", jobs, job_options.threads);
+                fflush(stdout);
+
+                // Der Hauptthread berechnet selbst mit dem ersten Kontext
+                for (unsigned w = 1; w < jobs; w++)
+                        workers[w].started = !pthread_create(&workers[w].thread, NULL, batch_main, &workers[w]);
+                batch_main(&workers[0]);
+        }
+        else
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+        }
+        for (unsigned w = 0; workers != NULL && w < jobs; w++)
+        {
+                if (workers[w].started)
+                        pthread_join(workers[w].thread, NULL);
+                render_context_destroy(workers[w].context);
+        }
+        double time = curtime() - start;
+
+        if (allocated)
+        {
+                printf("   %" PRIu64 " Aufträge in %f Sekunden (%f pro Sekunde), davon %" PRIu64 " fehlgeschlagen.\r\n",
+                       state.jobs, time, time > 0 ? (double)state.jobs / time : 0.0, state.failed);
+                fflush(stdout);
+        }
+        free(workers);
+        pthread_mutex_destroy(&state.input_lock);
+        if (!standard_input)
+                fclose(input);
+        return allocated && state.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,22 @@
+// Include Guards
+#ifndef BATCH_H
+#define BATCH_H
+#include "render.h"
+
+// Einstellungen des Batch-Modus
+typedef struct
+{
+        const char *input; // Datei mit einem Auftrag pro Zeile (NULL oder "-": stdin)
+        unsigned jobs;     // Gleichzeitig berechnete Aufträge (0: einer je Thread)
+} batch_settings;
+
+// batch: Berechnet die Aufträge der Eingabe, je Zeile einer im Format
+// "dateiname r_start r_end i_start i_end resolution i_max". Leere Zeilen und Zeilen,
+// die mit # beginnen, werden übersprungen. jobs Threads lesen abwechselnd die nächste
+// Zeile und berechnen sie mit einem eigenen Rechenkontext, der die Threads von
+// options gleichmäßig aufteilt und dessen Puffer für alle Aufträge erhalten bleiben.
+// Status und Dauer jedes Auftrags werden sofort ausgegeben. Gibt EXIT_SUCCESS zurück,
+// falls alle Aufträge erfolgreich waren, sonst EXIT_FAILURE
+int batch(const render_options *options, const batch_settings *settings);
+
+#endif // !BATCH_H
@@ -0,0 +1,236 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "timer.h"
+
+// Ausschnitt der Benchmarkauswahl
+struct bench_view
+{
+        const char *name;
+        double r_start;
+        double r_end;
+        double i_start;
+        double i_end;
+        double resolution;
+        int16_t max_iterations;
+};
+
+// Feste Auswahl an Ausschnitten. Sie decken die ganze Menge, einen Rand mit vielen
+// Filamenten, ein fast vollständig inneres Gebiet und hohe Iterationszahlen ab.
+// Änderungen machen ältere Ergebnisdateien unvergleichbar
+static const struct bench_view bench_views[] = {
+    {"full", -2, 1, -1, 1, 0.002, 255},
+    {"seahorse", -0.75, -0.73, 0.1, 0.12, 0.00002, 1000},
+    {"interior", -0.3, 0.1, -0.2, 0.2, 0.0004, 1000},
+    {"high_imax", -0.3, 0.1, 0.6, 1, 0.0004, 30000},
+};
+
+// compute_reference: Berechnet den Ausschnitt mit der C Referenzimplementierung (mit
+// fma in der Variante mit FMA Rundungen) auf dem Threadpool. Gibt 0 zurück, falls
+// kein Speicher verfügbar ist
+static _Bool compute_reference(threadpool *pool, const render_view *view, precision_tier precision, _Bool fma,
+                               uint16_t *counts, uint64_t tile_size)
+{
+        render_plan *plan = render_plan_create_reference(view, precision, fma);
+        if (plan == NULL)
+                return 0;
+        render_plan_rows(pool, plan, NULL, counts, view->width, 0, view->height, tile_size, RENDER_MODE_SCAN);
+        render_plan_destroy(plan);
+        return 1;
+}
+
+// count_mismatches: Zählt die Pixel, deren Zähler sich unterscheiden
+static uint64_t count_mismatches(const uint16_t *counts, const uint16_t *expected, size_t pixels)
+{
+        uint64_t mismatches = 0;
+        for (size_t i = 0; i < pixels; i++)
+                mismatches += counts[i] != expected[i];
+        return mismatches;
+}
+
+// compare_times: Vergleichsfunktion für qsort
+static int compare_times(const void *a, const void *b)
+{
+        double x = *(const double *)a;
+        double y = *(const double *)b;
+        return (x > y) - (x < y);
+}
+
+// percentile: Perzentil p (0 bis 1) der aufsteigend sortierten Zeiten nach der
+// Nearest-Rank Methode
+static double percentile(const double *times, unsigned count, double p)
+{
+        unsigned rank = (unsigned)(p * count + 0.999999);
+        return times[rank > 0 ? rank - 1 : 0];
+}
+
+int bench(const render_options *options, const bench_settings *settings)
+{
+        if (settings->repetitions == 0)
+        {
+                fprintf(stderr, "   Die Anzahl der Wiederholungen muss größer 0 sein.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        if (options->kernel != KERNEL_AUTO && !kernel_supported(options->kernel))
+        {
+                fprintf(stderr, "   Der Kernel %s wird von diesem Prozessor nicht unterstützt.\r\n", kernel_name(options->kernel));
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        FILE *file = fopen(settings->output, "w");
+        if (file == NULL)
+        {
+                fprintf(stderr, "   Die Datei %s konnte nicht erstellt werden.\r\n", settings->output);
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+        fprintf(file, "view,kernel,lanes,precision,mode,threads,width,height,max_iterations,iterations,"
+                      "repetitions,min_s,median_s,p95_s,mpixel_per_s,iterations_per_s,reference_mismatches\n");
+
+        threadpool *pool = threadpool_create(options->threads);
+        double *times = malloc(settings->repetitions * sizeof(*times));
+        if (pool == NULL || times == NULL)
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+                threadpool_destroy(pool);
+                free(times);
+                fclose(file);
+                return EXIT_FAILURE;
+        }
+
+        printf("   %-10s %-7s %-6s %10s %10s %10s %10s %10s %10s\r\n",
+               "Ausschnitt", "Kernel", "Lanes", "Min [s]", "Median [s]", "P95 [s]", "MPixel/s", "GIter/s", "Abw. [%]");
+        fflush(stdout);
+
+        int result = EXIT_SUCCESS;
+        for (unsigned v = 0; v < sizeof(bench_views) / sizeof(*bench_views) && result == EXIT_SUCCESS; v++)
+        {
+                const struct bench_view *entry = &bench_views[v];
+                precision_tier precision = precision_resolve(options->precision, entry->r_start, entry->r_end,
+                                                             entry->i_start, entry->i_end, entry->resolution);
+                render_view view = {
+                    .r_start = entry->r_start,
+                    .i_start = entry->i_start,
+                    .resolution = entry->resolution,
+                    .max_iterations = entry->max_iterations,
+                    .width = render_dimension(entry->r_start, entry->r_end, entry->resolution, precision),
+                    .height = render_dimension(entry->i_start, entry->i_end, entry->resolution, precision),
+                };
+                size_t stride = view.width;
+                size_t pixels = stride * view.height;
+                uint16_t *buffer = malloc(pixels * sizeof(uint16_t));
+                uint16_t *reference = malloc(pixels * sizeof(uint16_t));
+                uint16_t *fused = malloc(pixels * sizeof(uint16_t));
+                _Bool fused_ready = 0;
+                if (buffer == NULL || reference == NULL || fused == NULL ||
+                    !compute_reference(pool, &view, precision, 0, reference, options->tile_size))
+                {
+                        free(buffer);
+                        free(reference);
+                        free(fused);
+                        fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                        fflush(stderr);
+                        result = EXIT_FAILURE;
+                        break;
+                }
+
+                // Iterationen der Referenzimplementierung. Punkte der Menge zählen
+                // unabhängig von Abkürzungen mit max_iterations, damit Iterationen pro
+                // Sekunde auch algorithmische Verbesserungen widerspiegeln
+                uint64_t iterations = 0;
+                for (size_t i = 0; i < pixels; i++)
+                        iterations += reference[i];
+
+                for (kernel_variant kernel = KERNEL_C; kernel <= KERNEL_AVX512 && result == EXIT_SUCCESS; kernel++)
+                {
+                        if (options->kernel != KERNEL_AUTO ? kernel != options->kernel : !kernel_supported(kernel))
+                                continue;
+
+                        for (lane_mode lanes = LANES_GROUP; lanes <= LANES_UNROLL && result == EXIT_SUCCESS; lanes++)
+                        {
+                                // Varianten ohne eigenen Kernel nur einmal messen
+                                if (lanes != LANES_GROUP && kernel_get(kernel, lanes, view.max_iterations) ==
+                                                                kernel_get(kernel, LANES_GROUP, view.max_iterations))
+                                        continue;
+
+                                render_plan *plan = render_plan_create(&view, kernel, lanes, precision);
+                                if (plan == NULL)
+                                {
+                                        fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                                        fflush(stderr);
+                                        result = EXIT_FAILURE;
+                                        break;
+                                }
+
+                                // Aufwärmdurchläufe füllen Caches und bringen den Prozessor auf Takt
+                                for (unsigned i = 0; i < settings->warmup; i++)
+                                        render_plan_rows(pool, plan, NULL, buffer, stride, 0, view.height, options->tile_size, options->mode);
+                                for (unsigned i = 0; i < settings->repetitions; i++)
+                                {
+                                        double start = curtime();
+                                        render_plan_rows(pool, plan, NULL, buffer, stride, 0, view.height, options->tile_size, options->mode);
+                                        times[i] = curtime() - start;
+                                }
+                                render_plan_destroy(plan);
+
+                                // Alle Kernel und Zuordnungen müssen exakt die Zähler der
+                                // Referenzimplementierung liefern, die FMA Kernel die der
+                                // Referenz mit denselben FMA Rundungen. Der Anteil der
+                                // Abweichungen von der Referenz ohne FMA entspricht --verify
+                                _Bool fma = precision != PRECISION_PERTURBATION && kernel_uses_fma(kernel);
+                                if (fma && !fused_ready)
+                                        fused_ready = compute_reference(pool, &view, precision, 1, fused, options->tile_size);
+                                uint64_t reference_mismatches = count_mismatches(buffer, reference, pixels);
+                                uint64_t mismatches = fma ? (fused_ready ? count_mismatches(buffer, fused, pixels) : pixels)
+                                                          : reference_mismatches;
+                                if (mismatches > 0)
+                                {
+                                        fprintf(stderr, "   %s %s %s: %" PRIu64 " Pixel weichen von der Referenzimplementierung%s ab.\r\n",
+                                                entry->name, kernel_name(kernel), lane_mode_name(lanes), mismatches,
+                                                fma ? " mit FMA" : "");
+                                        fflush(stderr);
+                                        result = EXIT_FAILURE;
+                                }
+
+                                qsort(times, settings->repetitions, sizeof(*times), compare_times);
+                                double min = times[0];
+                                double median = percentile(times, settings->repetitions, 0.5);
+                                double p95 = percentile(times, settings->repetitions, 0.95);
+                                double mpixels = (double)(view.width * view.height) / median / 1e6;
+                                double iterations_per_second = (double)iterations / median;
+
+                                printf("   %-10s %-7s %-6s %10.6f %10.6f %10.6f %10.2f %10.3f %10.4f\r\n",
+                                       entry->name, kernel_name(kernel), lane_mode_name(lanes),
+                                       min, median, p95, mpixels, iterations_per_second / 1e9,
+                                       100.0 * (double)reference_mismatches / (double)pixels);
+                                fflush(stdout);
+                                fprintf(file, "%s,%s,%s,%s,%s,%u,%" PRIu64 ",%" PRIu64 ",%d,%" PRIu64 ",%u,%.9f,%.9f,%.9f,%.6f,%.0f,%" PRIu64 "\n",
+                                        entry->name, kernel_name(kernel), lane_mode_name(lanes), precision_name(precision),
+                                        render_mode_name(options->mode), threadpool_size(pool), view.width, view.height,
+                                        view.max_iterations, iterations, settings->repetitions, min, median, p95,
+                                        mpixels, iterations_per_second, reference_mismatches);
+                        }
+                }
+                free(buffer);
+                free(reference);
+                free(fused);
+        }
+
+        threadpool_destroy(pool);
+        free(times);
+        if (fclose(file) != 0 && result == EXIT_SUCCESS)
+        {
+                fprintf(stderr, "   Die Datei %s konnte nicht geschrieben werden.\r\n", settings->output);
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+        if (result == EXIT_SUCCESS)
+                printf("   Ergebnisse wurden in \"%s\" geschrieben.\r\n", settings->output);
+        return result;
+}
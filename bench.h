@@ -0,0 +1,22 @@
+// Include Guards
+#ifndef BENCH_H
+#define BENCH_H
+#include "render.h"
+
+// Einstellungen eines Benchmarklaufs
+typedef struct
+{
+        unsigned repetitions; // Gemessene Wiederholungen pro Ausschnitt und Kernel
+        unsigned warmup;      // Vorab verworfene Durchläufe
+        const char *output;   // Pfad der CSV Datei mit den Ergebnissen
+} bench_settings;
+
+// bench: Berechnet eine feste Auswahl an Ausschnitten mit jedem unterstützten Kernel
+// (bzw. nur mit dem in options erzwungenen) im Speicher, ohne Ausgabedatei. Gibt
+// Minimum, Median und 95. Perzentil der Laufzeiten sowie Pixel und Iterationen pro
+// Sekunde aus und schreibt sie als CSV Datei. Weichen die Zähler eines Kernels von der
+// Referenzimplementierung ab (bei FMA Kernels von der mit FMA Rundungen), schlägt der
+// Benchmark fehl. Gibt EXIT_SUCCESS oder EXIT_FAILURE zurück
+int bench(const render_options *options, const bench_settings *settings);
+
+#endif // !BENCH_H
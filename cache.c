@@ -0,0 +1,393 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cache.h"
+
+// Kennung und Version des Dateiformats
+#define CACHE_MAGIC 0x3143544d
+#define CACHE_VERSION 3
+
+// Größe eines serialisierten Schlüssels in Byte
+#define CACHE_KEY_SIZE 56
+
+// Die Zähler beginnen an einer Seitengrenze, damit jede Kachel ausgerichtet ist
+#define CACHE_PAGE_SIZE 4096
+
+// Kennzeichnet das Fehlen eines Nachbarn in der LRU Liste
+#define CACHE_NONE UINT32_MAX
+
+// Aufbau der Datei: Header, Tabelle der Einträge, Zähler aller Plätze. Die Zähler
+// von Platz n liegen direkt als uint16_t Zeilen ohne Abstand hintereinander, sodass
+// die Datei vollständig in den Speicher abgebildet werden kann
+struct cache_header
+{
+        uint32_t magic;
+        uint32_t version;
+        uint64_t slot_pixels; // Anzahl der Zähler pro Platz
+        uint64_t slot_count;  // Anzahl der Plätze
+        uint64_t clock;       // Zuletzt vergebener Zeitstempel
+};
+
+struct cache_entry
+{
+        uint64_t hash;                     // Hash des Schlüssels, 0: Platz unbelegt
+        uint64_t used;                     // Zeitstempel des letzten Zugriffs
+        unsigned char key[CACHE_KEY_SIZE]; // Serialisierter Schlüssel
+};
+
+struct tile_cache
+{
+        int fd;
+        void *map;
+        size_t map_size;
+        struct cache_header *header;
+        struct cache_entry *entries;
+        uint16_t *data;
+        uint64_t slots;
+
+        // Hashtabelle mit offener Adressierung von Schlüsseln auf Plätze. Enthält
+        // Platz + 1, 0 steht für eine freie Position
+        uint32_t *index;
+        uint64_t index_mask;
+
+        // Belegte Plätze als doppelt verkettete Liste vom zuletzt (head) zum am
+        // längsten nicht (tail) verwendeten Platz
+        uint32_t *prev;
+        uint32_t *next;
+        uint32_t head;
+        uint32_t tail;
+
+        // Unbelegte Plätze
+        uint32_t *free_slots;
+        uint64_t free_count;
+
+        uint64_t hits;
+        uint64_t misses;
+};
+
+// key_hash: Serialisiert den Schlüssel nach bytes und gibt dessen FNV-1a Hash
+// zurück. Der Hash ist nie 0, da dieser Wert unbelegte Plätze kennzeichnet
+static uint64_t key_hash(const tile_key *key, unsigned char *bytes)
+{
+        unsigned char *p = bytes;
+        memset(bytes, 0, CACHE_KEY_SIZE);
+        memcpy(p, &key->r, sizeof(key->r));
+        p += sizeof(key->r);
+        memcpy(p, &key->i, sizeof(key->i));
+        p += sizeof(key->i);
+        memcpy(p, &key->resolution, sizeof(key->resolution));
+        p += sizeof(key->resolution);
+        memcpy(p, &key->max_iterations, sizeof(key->max_iterations));
+        p += sizeof(key->max_iterations);
+        memcpy(p, &key->precision, sizeof(key->precision));
+        p += sizeof(key->precision);
+        memcpy(p, &key->fma, sizeof(key->fma));
+        p += sizeof(key->fma);
+        memcpy(p, &key->mode, sizeof(key->mode));
+        p += sizeof(key->mode);
+        memcpy(p, &key->width, sizeof(key->width));
+        p += sizeof(key->width);
+        memcpy(p, &key->height, sizeof(key->height));
+
+        uint64_t hash = 0xcbf29ce484222325;
+        for (unsigned i = 0; i < CACHE_KEY_SIZE; i++)
+                hash = (hash ^ bytes[i]) * 0x100000001b3;
+        return hash != 0 ? hash : 1;
+}
+
+// index_find: Gibt die Position des Schlüssels in der Hashtabelle zurück oder die
+// freie Position, an der er einzufügen wäre. Die Tabelle ist mindestens doppelt so
+// groß wie die Anzahl der Plätze und hat daher immer freie Positionen
+static uint64_t index_find(const tile_cache *cache, uint64_t hash, const unsigned char *key)
+{
+        for (uint64_t pos = hash & cache->index_mask;; pos = (pos + 1) & cache->index_mask)
+        {
+                uint32_t slot = cache->index[pos];
+                if (slot == 0)
+                        return pos;
+                const struct cache_entry *entry = &cache->entries[slot - 1];
+                if (entry->hash == hash && !memcmp(entry->key, key, CACHE_KEY_SIZE))
+                        return pos;
+        }
+}
+
+// index_remove: Entfernt den Eintrag an Position pos. Nachfolgende Einträge derselben
+// Kette werden nachgerückt, damit index_find sie weiterhin findet
+static void index_remove(tile_cache *cache, uint64_t pos)
+{
+        uint64_t mask = cache->index_mask;
+        for (uint64_t next = (pos + 1) & mask; cache->index[next] != 0; next = (next + 1) & mask)
+        {
+                uint64_t home = cache->entries[cache->index[next] - 1].hash & mask;
+                if (((next - home) & mask) >= ((next - pos) & mask))
+                {
+                        cache->index[pos] = cache->index[next];
+                        pos = next;
+                }
+        }
+        cache->index[pos] = 0;
+}
+
+// lru_unlink: Entfernt einen Platz aus der LRU Liste
+static void lru_unlink(tile_cache *cache, uint32_t slot)
+{
+        if (cache->prev[slot] != CACHE_NONE)
+                cache->next[cache->prev[slot]] = cache->next[slot];
+        else
+                cache->head = cache->next[slot];
+        if (cache->next[slot] != CACHE_NONE)
+                cache->prev[cache->next[slot]] = cache->prev[slot];
+        else
+                cache->tail = cache->prev[slot];
+}
+
+// lru_push: Stellt einen Platz als zuletzt verwendet an den Anfang der LRU Liste
+static void lru_push(tile_cache *cache, uint32_t slot)
+{
+        cache->prev[slot] = CACHE_NONE;
+        cache->next[slot] = cache->head;
+        if (cache->head != CACHE_NONE)
+                cache->prev[cache->head] = slot;
+        else
+                cache->tail = slot;
+        cache->head = slot;
+}
+
+// Sortierhilfe zum Aufbau der LRU Liste beim Öffnen
+struct slot_use
+{
+        uint64_t used;
+        uint32_t slot;
+};
+
+static int compare_use(const void *a, const void *b)
+{
+        uint64_t x = ((const struct slot_use *)a)->used;
+        uint64_t y = ((const struct slot_use *)b)->used;
+        return (x > y) - (x < y);
+}
+
+// cache_build: Baut Hashtabelle, LRU Liste und die Liste der unbelegten Plätze aus
+// der Tabelle der Einträge auf. Gibt 0 zurück, falls kein Speicher verfügbar ist
+static _Bool cache_build(tile_cache *cache)
+{
+        struct slot_use *uses = malloc(cache->slots * sizeof(*uses));
+        if (uses == NULL)
+                return 0;
+
+        uint64_t used = 0;
+        for (uint64_t slot = 0; slot < cache->slots; slot++)
+        {
+                struct cache_entry *entry = &cache->entries[slot];
+                if (entry->hash != 0)
+                {
+                        // Doppelte Einträge können nur durch einen Abbruch während
+                        // des Schreibens entstehen und werden verworfen
+                        uint64_t pos = index_find(cache, entry->hash, entry->key);
+                        if (cache->index[pos] == 0)
+                        {
+                                cache->index[pos] = (uint32_t)slot + 1;
+                                uses[used++] = (struct slot_use){entry->used, (uint32_t)slot};
+                                continue;
+                        }
+                        entry->hash = 0;
+                }
+                cache->free_slots[cache->free_count++] = (uint32_t)slot;
+        }
+
+        qsort(uses, used, sizeof(*uses), compare_use);
+        for (uint64_t i = 0; i < used; i++)
+                lru_push(cache, uses[i].slot);
+        free(uses);
+        return 1;
+}
+
+tile_cache *tile_cache_open(const char *path, uint64_t max_bytes, uint64_t tile_pixels)
+{
+        // Jeder Platz besteht aus seinem Eintrag und den Zählern einer Kachel
+        uint64_t slot_size = sizeof(struct cache_entry) + tile_pixels * sizeof(uint16_t);
+        uint64_t slots = tile_pixels == 0 || max_bytes < 2 * CACHE_PAGE_SIZE ? 0 : (max_bytes - 2 * CACHE_PAGE_SIZE) / slot_size;
+        if (slots == 0 || slots >= UINT32_MAX)
+                return NULL;
+        size_t data_offset = (sizeof(struct cache_header) + slots * sizeof(struct cache_entry) + CACHE_PAGE_SIZE - 1) /
+                             CACHE_PAGE_SIZE * CACHE_PAGE_SIZE;
+        size_t size = data_offset + slots * tile_pixels * sizeof(uint16_t);
+
+        // Gleichzeitige Prozesse würden sich gegenseitig Plätze überschreiben,
+        // daher wird die Datei exklusiv gesperrt
+        int fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+                return NULL;
+        if (flock(fd, LOCK_EX | LOCK_NB))
+        {
+                close(fd);
+                return NULL;
+        }
+
+        struct stat st;
+        struct cache_header header;
+        _Bool valid = !fstat(fd, &st) && (uint64_t)st.st_size == size &&
+                      pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                      header.magic == CACHE_MAGIC && header.version == CACHE_VERSION &&
+                      header.slot_pixels == tile_pixels && header.slot_count == slots;
+
+        // Eine neu angelegte Datei besteht nur aus Nullen, alle Plätze sind damit
+        // unbelegt
+        if (!valid && (ftruncate(fd, 0) || ftruncate(fd, (off_t)size)))
+        {
+                close(fd);
+                return NULL;
+        }
+
+        void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED)
+        {
+                close(fd);
+                return NULL;
+        }
+
+        uint64_t index_size = 1;
+        while (index_size < 2 * slots)
+                index_size *= 2;
+
+        tile_cache *cache = calloc(1, sizeof(*cache));
+        if (cache != NULL)
+        {
+                *cache = (tile_cache){
+                    .fd = fd,
+                    .map = map,
+                    .map_size = size,
+                    .header = map,
+                    .entries = (struct cache_entry *)((struct cache_header *)map + 1),
+                    .data = (uint16_t *)((unsigned char *)map + data_offset),
+                    .slots = slots,
+                    .index = calloc(index_size, sizeof(uint32_t)),
+                    .index_mask = index_size - 1,
+                    .prev = malloc(slots * sizeof(uint32_t)),
+                    .next = malloc(slots * sizeof(uint32_t)),
+                    .head = CACHE_NONE,
+                    .tail = CACHE_NONE,
+                    .free_slots = malloc(slots * sizeof(uint32_t)),
+                };
+        }
+        if (cache == NULL || cache->index == NULL || cache->prev == NULL || cache->next == NULL ||
+            cache->free_slots == NULL)
+        {
+                tile_cache_close(cache);
+                if (cache == NULL)
+                {
+                        munmap(map, size);
+                        close(fd);
+                }
+                return NULL;
+        }
+
+        if (!valid)
+        {
+                *cache->header = (struct cache_header){
+                    .magic = CACHE_MAGIC,
+                    .version = CACHE_VERSION,
+                    .slot_pixels = tile_pixels,
+                    .slot_count = slots,
+                };
+        }
+
+        if (!cache_build(cache))
+        {
+                tile_cache_close(cache);
+                return NULL;
+        }
+        return cache;
+}
+
+_Bool tile_cache_get(tile_cache *cache, const tile_key *key, uint16_t *counts, size_t stride)
+{
+        unsigned char bytes[CACHE_KEY_SIZE];
+        uint64_t hash = key_hash(key, bytes);
+        uint32_t slot = cache->index[index_find(cache, hash, bytes)];
+        if (slot == 0)
+        {
+                cache->misses++;
+                return 0;
+        }
+        slot--;
+
+        const uint16_t *data = cache->data + slot * cache->header->slot_pixels;
+        for (uint32_t row = 0; row < key->height; row++)
+                memcpy(counts + row * stride, data + row * key->width, key->width * sizeof(uint16_t));
+
+        cache->entries[slot].used = ++cache->header->clock;
+        lru_unlink(cache, slot);
+        lru_push(cache, slot);
+        cache->hits++;
+        return 1;
+}
+
+void tile_cache_put(tile_cache *cache, const tile_key *key, const uint16_t *counts, size_t stride)
+{
+        if ((uint64_t)key->width * key->height > cache->header->slot_pixels)
+                return;
+
+        unsigned char bytes[CACHE_KEY_SIZE];
+        uint64_t hash = key_hash(key, bytes);
+        uint64_t pos = index_find(cache, hash, bytes);
+        uint32_t slot;
+        if (cache->index[pos] != 0)
+        {
+                slot = cache->index[pos] - 1;
+                lru_unlink(cache, slot);
+        }
+        else
+        {
+                // Unbelegten Platz verwenden oder den am längsten nicht verwendeten
+                // Platz verdrängen. Danach hat sich die Hashtabelle verändert
+                if (cache->free_count > 0)
+                {
+                        slot = cache->free_slots[--cache->free_count];
+                }
+                else
+                {
+                        slot = cache->tail;
+                        struct cache_entry *old = &cache->entries[slot];
+                        index_remove(cache, index_find(cache, old->hash, old->key));
+                        lru_unlink(cache, slot);
+                        pos = index_find(cache, hash, bytes);
+                }
+                cache->index[pos] = slot + 1;
+        }
+
+        // Der Platz gilt erst nach dem Schreiben der Zähler wieder als belegt, damit
+        // ein Abbruch keine unvollständige Kachel hinterlässt
+        struct cache_entry *entry = &cache->entries[slot];
+        entry->hash = 0;
+        uint16_t *data = cache->data + slot * cache->header->slot_pixels;
+        for (uint32_t row = 0; row < key->height; row++)
+                memcpy(data + row * key->width, counts + row * stride, key->width * sizeof(uint16_t));
+        memcpy(entry->key, bytes, CACHE_KEY_SIZE);
+        entry->used = ++cache->header->clock;
+        entry->hash = hash;
+        lru_push(cache, slot);
+}
+
+void tile_cache_stats(const tile_cache *cache, uint64_t *hits, uint64_t *misses)
+{
+        *hits = cache->hits;
+        *misses = cache->misses;
+}
+
+void tile_cache_close(tile_cache *cache)
+{
+        if (cache == NULL)
+                return;
+        munmap(cache->map, cache->map_size);
+        close(cache->fd);
+        free(cache->index);
+        free(cache->prev);
+        free(cache->next);
+        free(cache->free_slots);
+        free(cache);
+}
@@ -0,0 +1,49 @@
+// Include Guards
+#ifndef CACHE_H
+#define CACHE_H
+#include <stddef.h>
+#include <stdint.h>
+#include "deepzoom.h"
+
+// Schlüssel einer Kachel im Cache. Eine Kachel wird über die Koordinaten ihres
+// ersten Pixels und alle Größen identifiziert, die ihre Iterationszähler bestimmen
+typedef struct
+{
+        hp_float r;             // Realteil des ersten Pixels in Vielfachen der Resolution
+        hp_float i;             // Imaginärteil des ersten Pixels in Vielfachen der Resolution
+        double resolution;      // Abstand zweier Pixel
+        int16_t max_iterations; // Maximale Anzahl an Iterationen
+        uint8_t precision;      // Genauigkeitsstufe der Berechnung (s. render.h)
+        uint8_t fma;            // Berechnet von einem Kernel mit FMA Befehlen (s. kernel.h)
+        uint8_t mode;           // Reihenfolge der Berechnung innerhalb der Kachel (s. render.h)
+        uint32_t width;         // Breite der Kachel in Pixeln
+        uint32_t height;        // Höhe der Kachel in Pixeln
+} tile_key;
+
+// Undurchsichtiger Typ des Kachel-Caches (s. cache.c)
+typedef struct tile_cache tile_cache;
+
+// tile_cache_open: Öffnet die Cache-Datei path oder legt sie neu an. Die Datei wird
+// höchstens max_bytes groß und nimmt Kacheln mit bis zu tile_pixels Pixeln auf.
+// Passen Größe oder Kachelgröße einer vorhandenen Datei nicht, wird sie geleert.
+// Gibt NULL zurück, falls die Datei nicht geöffnet werden konnte oder bereits von
+// einem anderen Prozess verwendet wird
+tile_cache *tile_cache_open(const char *path, uint64_t max_bytes, uint64_t tile_pixels);
+
+// tile_cache_get: Kopiert die Iterationszähler der Kachel key zeilenweise mit einem
+// Zeilenabstand von stride Pixeln nach counts. Gibt 0 zurück, falls die Kachel
+// nicht im Cache liegt
+_Bool tile_cache_get(tile_cache *cache, const tile_key *key, uint16_t *counts, size_t stride);
+
+// tile_cache_put: Legt die Iterationszähler der Kachel key im Cache ab. Ist der Cache
+// voll, wird die am längsten nicht verwendete Kachel verdrängt. Zu große Kacheln
+// werden nicht abgelegt
+void tile_cache_put(tile_cache *cache, const tile_key *key, const uint16_t *counts, size_t stride);
+
+// tile_cache_stats: Gibt die Anzahl der Treffer und Fehlschläge seit dem Öffnen zurück
+void tile_cache_stats(const tile_cache *cache, uint64_t *hits, uint64_t *misses);
+
+// tile_cache_close: Schreibt den Cache zurück in die Datei und gibt ihn frei
+void tile_cache_close(tile_cache *cache);
+
+#endif // !CACHE_H
@@ -0,0 +1,714 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "context.h"
+#include "timer.h"
+
+// Ein Kontext hält alles, was über einen Auftrag hinaus wiederverwendet werden kann.
+// Die Puffer wachsen mit dem größten bisherigen Auftrag
+struct render_context
+{
+        render_options options;
+        threadpool *pool;
+        threadpool *reference_pool; // Erst bei der ersten Überprüfung erstellt
+        tile_cache *cache;
+        uint16_t *counts;           // Iterationszähler eines Streifens
+        size_t counts_size;         // Anzahl der Zähler, für die counts reicht
+        uint16_t *comparison;       // Zähler der Referenzimplementierung
+        size_t comparison_size;
+        uint16_t *sources;          // Quellzeilen der gespiegelten Zeilen
+        size_t sources_size;
+        render_samples samples;     // Stichproben der Randpixel eines Streifens
+        render_stats stats;         // Messwerte des letzten Auftrags, falls stats_path gesetzt ist
+        char *paths[PALETTE_COUNT]; // Dateien des letzten Auftrags
+        char error[1024];           // Beschreibung des letzten Fehlers
+};
+
+// Gespiegelte Zeilen eines Auftrags (s. render_plan_mirror_axis). Die Zeilen [first;last]
+// werden nicht berechnet, sondern aus den Quellzeilen axis - y kopiert. Diese liegen
+// in der Reihenfolge der Streifen davor und werden bei ihrer Berechnung ab
+// context->sources abgelegt, die Zeile axis - last zuerst. Ohne Spiegelung ist first > last
+struct mirror
+{
+        uint64_t axis;
+        uint64_t first;
+        uint64_t last;
+};
+
+// compare_counts: Zählt die Pixel, deren Iterationszähler sich von den erwarteten
+// unterscheiden
+static uint64_t compare_counts(const uint16_t *counts, const uint16_t *expected, uint64_t pixels)
+{
+        uint64_t counter = 0;
+        for (uint64_t i = 0; i < pixels; i++)
+        {
+                if (counts[i] != expected[i])
+                        counter++;
+        }
+        return counter;
+}
+
+// random_next: Nächste Zahl des Xorshift Generators (Marsaglia). Der Zustand darf
+// nicht 0 sein
+static uint64_t random_next(uint64_t *state)
+{
+        uint64_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        *state = x;
+        return x;
+}
+
+// fail: Hält die Beschreibung eines Fehlers fest und gibt dessen Status zurück
+static render_status fail(render_context *context, render_status status, const char *format, ...)
+{
+        va_list args;
+        va_start(args, format);
+        vsnprintf(context->error, sizeof(context->error), format, args);
+        va_end(args);
+        return status;
+}
+
+// reserve: Vergrößert einen Puffer auf mindestens count Zähler. Gibt 0 zurück,
+// falls kein Speicher verfügbar ist
+static _Bool reserve(uint16_t **buffer, size_t *size, size_t count)
+{
+        if (count <= *size)
+                return 1;
+        uint16_t *grown = realloc(*buffer, count * sizeof(uint16_t));
+        if (grown == NULL)
+                return 0;
+        *buffer = grown;
+        *size = count;
+        return 1;
+}
+
+// validate: Prüft die Eingaben eines Auftrags in der Reihenfolge der ursprünglichen
+// Kommandozeilenprüfung
+static render_status validate(render_context *context, const render_request *request)
+{
+        // Die Resolution muss größer 0 sein, da sonst das Bild eine unendliche
+        // oder negative Größe hätte
+        if (request->resolution <= 0)
+                return fail(context, RENDER_ERROR_INPUT, "Die Resolution darf nicht negativ oder 0 sein.");
+
+        // Anzahl maximaler Iterationen darf nicht kleiner 0 sein. Eine ungewollt
+        // negative Eingabe könnte bei unsigned Integern zu ungewollt hohen
+        // Iterationsanzahlen führen
+        if (request->max_iterations < 0)
+                return fail(context, RENDER_ERROR_INPUT, "Die Anzahl der maximalen Iterationen darf nicht kleiner 0 sein.");
+
+        // Liegt die Eingabe für r_start nicht innerhalb des Intervalls [-2;1]
+        // würden zu viele sinnlose Berechnung durchgeführt werden
+        // Gleiches wird für die übrigen Abmessungsparameter überprüft
+        if (request->r_start < -2 || request->r_start > 1)
+                return fail(context, RENDER_ERROR_INPUT, "Die Eingabe für r_start muss im Interval [-2;1] liegen.");
+        if (request->r_end < -2 || request->r_end > 1)
+                return fail(context, RENDER_ERROR_INPUT, "Die Eingabe für r_end muss im Interval [-2;1] liegen.");
+        if (request->i_start < -1 || request->i_start > 1)
+                return fail(context, RENDER_ERROR_INPUT, "Die Eingabe für i_start muss im Interval [-1;1] liegen.");
+        if (request->i_end < -1 || request->i_end > 1)
+                return fail(context, RENDER_ERROR_INPUT, "Die Eingabe für i_end muss im Interval [-1;1] liegen.");
+        return RENDER_OK;
+}
+
+// report_tiles: Meldet die Kacheln der Zeilen [y;y+rows) an den Callback. Gibt 0
+// zurück, falls der Callback abbricht
+static _Bool report_tiles(const render_sink *sink, const uint16_t *counts, uint64_t width, uint64_t y, uint64_t rows,
+                          uint64_t tile_size)
+{
+        for (uint64_t row = 0; row < rows; row += tile_size)
+        {
+                for (uint64_t x = 0; x < width; x += tile_size)
+                {
+                        render_tile tile = {
+                            .x = x,
+                            .y = y + row,
+                            .width = width - x < tile_size ? width - x : tile_size,
+                            .height = rows - row < tile_size ? rows - row : tile_size,
+                            .counts = counts + row * width + x,
+                            .stride = width,
+                        };
+                        if (!sink->tile(sink->user, &tile))
+                                return 0;
+                }
+        }
+        return 1;
+}
+
+render_context *render_context_create(const render_options *options)
+{
+        render_context *context = calloc(1, sizeof(*context));
+        if (context == NULL)
+                return NULL;
+        context->options = *options;
+        context->pool = threadpool_create(options->threads);
+        if (context->pool == NULL)
+        {
+                free(context);
+                return NULL;
+        }
+
+        // Bereits berechnete Kacheln werden aus der Datei übernommen, neue dort
+        // abgelegt. Ist die Datei nicht verfügbar, wird ohne Cache gerechnet
+        if (options->cache_path != NULL)
+                context->cache = tile_cache_open(options->cache_path, options->cache_size,
+                                                 options->tile_size * options->tile_size);
+        return context;
+}
+
+const char *render_context_error(const render_context *context)
+{
+        return context->error;
+}
+
+void render_context_destroy(render_context *context)
+{
+        if (context == NULL)
+                return;
+        if (context->cache != NULL)
+                tile_cache_close(context->cache);
+        threadpool_destroy(context->pool);
+        threadpool_destroy(context->reference_pool);
+        for (unsigned p = 0; p < PALETTE_COUNT; p++)
+                free(context->paths[p]);
+        free(context->counts);
+        free(context->comparison);
+        free(context->sources);
+        render_samples_free(&context->samples);
+        render_stats_free(&context->stats);
+        free(context);
+}
+
+// render_rows: Berechnet die Zeilen [y;y+rows) des Bildes nach counts mit einem
+// Zeilenabstand von width Pixeln. Gespiegelte Zeilen werden nur kopiert, berechnete
+// Quellzeilen für später gespiegelte Zeilen abgelegt
+static void render_rows(render_context *context, const render_plan *plan, const struct mirror *mirror,
+                        uint16_t *counts, uint64_t width, uint64_t y, uint64_t rows)
+{
+        const render_options *options = &context->options;
+        uint64_t end = y + rows;
+        uint64_t first = mirror->first > y ? mirror->first : y;
+        uint64_t last = mirror->last + 1 < end ? mirror->last + 1 : end;
+        if (first >= last)
+                first = last = end;
+
+        // Berechnet werden nur die Zeilen vor und nach den gespiegelten
+        if (first > y)
+                render_plan_rows(context->pool, plan, context->cache, counts, width, y, first - y, options->tile_size,
+                                 options->mode);
+        if (end > last)
+                render_plan_rows(context->pool, plan, context->cache, counts + (last - y) * width, width, last,
+                                 end - last, options->tile_size, options->mode);
+        if (mirror->first > mirror->last)
+                return;
+
+        // Quellzeilen desselben Streifens werden vor dem Kopieren abgelegt
+        uint64_t source_first = mirror->axis - mirror->last;
+        uint64_t source_last = mirror->axis - mirror->first;
+        for (uint64_t row = y; row < end; row++)
+        {
+                if (row >= source_first && row <= source_last)
+                        memcpy(context->sources + (row - source_first) * width, counts + (row - y) * width,
+                               width * sizeof(uint16_t));
+        }
+        for (uint64_t row = first; row < last; row++)
+                memcpy(counts + (row - y) * width, context->sources + (mirror->axis - row - source_first) * width,
+                       width * sizeof(uint16_t));
+}
+
+// close_files: Schließt alle Dateien eines Auftrags und gibt die Farbtabellen frei.
+// Gibt 0 zurück, falls eine Datei nicht vollständig geschrieben werden konnte, und
+// setzt dann *failed (falls nicht NULL) auf die erste solche Datei
+static _Bool close_files(image_writer **writers, palette **palettes, unsigned count, unsigned *failed)
+{
+        _Bool closed = 1;
+        for (unsigned p = 0; p < count; p++)
+        {
+                if (writers[p] != NULL && !image_writer_close(writers[p]) && closed)
+                {
+                        if (failed != NULL)
+                                *failed = p;
+                        closed = 0;
+                }
+                palette_destroy(palettes[p]);
+        }
+        return closed;
+}
+
+// open_files: Erstellt für jedes Farbschema eine Datei. Die erste trägt den Dateinamen
+// des Auftrags, weitere zusätzlich den Namen ihres Schemas. Im Fehlerfall sind alle
+// Dateien bereits wieder geschlossen
+static render_status open_files(render_context *context, const char *file_name, image_format format, uint64_t width,
+                                uint64_t height, uint64_t strip_height, int16_t max_iterations,
+                                image_writer **writers, palette **palettes)
+{
+        const render_options *options = &context->options;
+        for (unsigned p = 0; p < options->palette_count; p++)
+        {
+                size_t length = strlen(file_name) + 24;
+                char *path = realloc(context->paths[p], length);
+                if (path == NULL)
+                {
+                        close_files(writers, palettes, p, NULL);
+                        return fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+                }
+                context->paths[p] = path;
+                if (p == 0)
+                        snprintf(path, length, "%s%s", file_name, image_format_extension(format));
+                else
+                        snprintf(path, length, "%s_%s%s", file_name, palette_name(options->palettes[p]),
+                                 image_format_extension(format));
+
+                // Indizierte Formate übernehmen die Farbtabelle des Schemas
+                palettes[p] = palette_create(options->palettes[p], max_iterations, image_format_rgb(format));
+                if (palettes[p] == NULL)
+                {
+                        close_files(writers, palettes, p, NULL);
+                        return fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+                }
+                image_writer_settings settings = {.rows_per_strip = strip_height, .pool = context->pool};
+                settings.colors = palette_colors(palettes[p], &settings.color_count);
+
+                // Pointer auf Anfang einer Datei wird erstellt, die bei nicht-
+                // Existenz neu erstellt oder bei Existenz geleert wird.
+                writers[p] = image_writer_open(path, format, width, height, &settings);
+                if (writers[p] == NULL)
+                {
+                        close_files(writers, palettes, p + 1, NULL);
+                        return fail(context, RENDER_ERROR_FILE, "Die Datei %s konnte nicht erstellt werden.", path);
+                }
+        }
+        return RENDER_OK;
+}
+
+// write_rows: Färbt die Zähler der Zeilen [y;y+rows) mit jedem Farbschema direkt in
+// die Zeilen der Dateien ein und addiert die Dauer zu *time. Randpixel erhalten
+// den Mittelwert ihrer Stichproben, falls samples nicht NULL ist
+static render_status write_rows(render_context *context, image_format format, image_writer **writers,
+                                palette **palettes, unsigned file_count, const uint16_t *counts, uint64_t width,
+                                uint64_t y, uint64_t rows, const render_samples *samples, double *time)
+{
+        for (unsigned p = 0; p < file_count; p++)
+        {
+                // Gestreamte Formate komprimieren hier die vorherigen Zeilen
+                ptrdiff_t stride;
+                double write_start = curtime();
+                unsigned char *pixels = image_writer_rows(writers[p], y, rows, &stride);
+                context->stats.write_time += curtime() - write_start;
+                if (pixels == NULL)
+                        return fail(context, RENDER_ERROR_FILE, "Die Datei %s konnte nicht geschrieben werden.",
+                                    context->paths[p]);
+
+                double start = curtime();
+                if (image_format_indexed(format))
+                        palette_index_rows(palettes[p], counts, width, pixels, stride, width, rows);
+                else
+                        palette_apply_rows(palettes[p], counts, width, pixels, stride, width, rows);
+                if (samples != NULL)
+                        render_samples_apply(samples, palettes[p], pixels, stride);
+                double color_time = curtime() - start;
+                context->stats.color_time += color_time;
+                *time += color_time;
+        }
+        return RENDER_OK;
+}
+
+// finish_files: Schließt die Dateien. Ein Fehler beim Schreiben überdeckt keinen
+// früheren Fehler status
+static render_status finish_files(render_context *context, image_writer **writers, palette **palettes,
+                                  unsigned file_count, render_status status)
+{
+        unsigned failed = 0;
+        double start = curtime();
+        _Bool closed = close_files(writers, palettes, file_count, &failed);
+        context->stats.write_time += curtime() - start;
+        if (!closed && status == RENDER_OK)
+                status = fail(context, RENDER_ERROR_FILE, "Die Datei %s konnte nicht geschrieben werden.",
+                              context->paths[failed]);
+        return status;
+}
+
+// write_cell_times: Schreibt die Zeitkarte als CSV Datei mit der Kernelzeit jeder
+// Zelle in Millisekunden. Die erste Zeile der Datei ist wie im Bild die oberste
+// (i_end). Gibt 0 zurück, falls die Datei nicht geschrieben werden konnte
+static _Bool write_cell_times(const render_stats *stats, const char *path)
+{
+        FILE *file = fopen(path, "w");
+        if (file == NULL)
+                return 0;
+        for (uint64_t row = stats->rows; row-- > 0;)
+        {
+                const uint64_t *cells = stats->cell_time + row * stats->columns;
+                for (uint64_t column = 0; column < stats->columns; column++)
+                        fprintf(file, column == 0 ? "%.3f" : ",%.3f", cells[column] * 1e-6);
+                fputc('\n', file);
+        }
+        _Bool written = !ferror(file);
+        return fclose(file) == 0 && written;
+}
+
+// render_progressive: Berechnet das ganze Bild in den Durchläufen von
+// render_plan_pass. Nach jedem Durchlauf wird die Vorschau gemeldet und, außer nach
+// dem letzten, als Zwischenstand in die Dateien geschrieben. Den letzten Stand
+// schreibt render_context_run wie gewohnt
+static render_status render_progressive(render_context *context, const render_request *request, const render_plan *plan,
+                                        uint16_t *counts, image_format format, uint64_t width, uint64_t height,
+                                        double *time)
+{
+        const render_options *options = &context->options;
+        const char *file_name = request->sink.file_name;
+        for (unsigned pass = 0; pass < RENDER_PASSES; pass++)
+        {
+                double start = curtime();
+                _Bool computed = render_plan_pass(context->pool, plan, counts, pass, options->tile_size, options->mode);
+                *time += curtime() - start;
+                if (!computed)
+                        return fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+
+                render_tile image = {.width = width, .height = height, .counts = counts, .stride = width};
+                if (request->sink.pass != NULL && !request->sink.pass(request->sink.user, pass, &image))
+                        return fail(context, RENDER_ERROR_CANCELLED, "Die Berechnung wurde abgebrochen.");
+
+                if (file_name == NULL || pass + 1 == RENDER_PASSES)
+                        continue;
+                image_writer *writers[PALETTE_COUNT] = {NULL};
+                palette *palettes[PALETTE_COUNT] = {NULL};
+                render_status status = open_files(context, file_name, format, width, height, height,
+                                                  request->max_iterations, writers, palettes);
+                if (status != RENDER_OK)
+                        return status;
+                status = write_rows(context, format, writers, palettes, options->palette_count, counts, width, 0,
+                                    height, NULL, time);
+                status = finish_files(context, writers, palettes, options->palette_count, status);
+                if (status != RENDER_OK)
+                        return status;
+        }
+        return RENDER_OK;
+}
+
+render_status render_context_run(render_context *context, const render_request *request, render_result *result)
+{
+        const render_options *options = &context->options;
+        render_result local;
+        if (result == NULL)
+                result = &local;
+        memset(result, 0, sizeof(*result));
+        context->error[0] = '\0';
+
+        render_status status = validate(context, request);
+        if (status != RENDER_OK)
+                return status;
+        context->stats.color_time = 0;
+        context->stats.write_time = 0;
+
+        // Genauigkeitsstufe wählen. Einfache Genauigkeit reicht nur, solange sich
+        // benachbarte Pixel in float noch deutlich unterscheiden, danach wird mit
+        // double und bei tiefen Zooms mit Störungsrechnung gearbeitet
+        precision_tier precision = precision_resolve(options->precision, request->r_start, request->r_end,
+                                                     request->i_start, request->i_end, request->resolution);
+
+        // Berechnung der Höhe und Breite des Bildes und Verkleinerung auf
+        // Vielfaches von 4. Für Optimierung in Assembly Implementierung
+        uint64_t width = render_dimension(request->r_start, request->r_end, request->resolution, precision);
+        uint64_t height = render_dimension(request->i_start, request->i_end, request->resolution, precision);
+
+        // Höhe und Breite des Bildes dürfen nicht 0 sein und keinen Integer
+        // Overflow erzeugen, sobald sie zur Bildgröße zusammengerechnet werden.
+        // Zur Sicherheit darf das erzeugte Bild nicht größer als RENDER_MAX_IMAGE_SIZE sein
+        if (width == 0 || height == 0 || width > RENDER_MAX_IMAGE_SIZE / 3 / height)
+                return fail(context, RENDER_ERROR_SIZE,
+                            "Mit den eingegebenen Parametern kann keine Berechnung durchgeführt werden.");
+
+        // Bilder, deren Größe nicht in die 32 Bit Felder des BMP Headers passt,
+        // werden als BigTIFF geschrieben
+        image_format format = image_format_resolve(options->format, width, height);
+        if (format == IMAGE_FORMAT_AUTO)
+                return fail(context, RENDER_ERROR_FORMAT, "Das Bild ist für das gewählte Dateiformat zu groß.");
+
+        // Geglättete Randpixel haben Mischfarben, die keine Farbtabelle enthält
+        _Bool antialias = options->antialias > 1;
+        if (antialias && image_format_indexed(format))
+                return fail(context, RENDER_ERROR_FORMAT, "Die Kantenglättung ist nur mit bmp und bigtiff möglich.");
+        if (options->antialias > RENDER_MAX_ANTIALIAS)
+                return fail(context, RENDER_ERROR_INPUT, "Die Kantenglättung ist mit höchstens %u x %u Stichproben möglich.",
+                            RENDER_MAX_ANTIALIAS, RENDER_MAX_ANTIALIAS);
+
+        // Der gewählte Kernel muss vom Prozessor unterstützt werden
+        kernel_variant kernel = kernel_resolve(options->kernel);
+        if (!kernel_supported(kernel))
+                return fail(context, RENDER_ERROR_KERNEL, "Der Kernel %s wird von diesem Prozessor nicht unterstützt.",
+                            kernel_name(kernel));
+
+        // Das Bild wird in Streifen von strip_height Zeilen berechnet und jeder
+        // Streifen sofort geschrieben und gemeldet. Der Speicherbedarf hängt daher
+        // nur von der Breite und der Streifenhöhe ab. Der progressive Modus benötigt
+        // die Zähler des ganzen Bildes. Zur Suche der Randpixel wird jeder Streifen
+        // mit der Zeile darunter und darüber berechnet, die vor counts bzw. nach
+        // dessen letzter Zeile liegen
+        uint64_t strip_height = options->strip_height == 0 || options->strip_height > height || options->progressive
+                                    ? height
+                                    : options->strip_height;
+        uint64_t halo = antialias ? 1 : 0;
+        if (!reserve(&context->counts, &context->counts_size, width * (strip_height + 2 * halo)))
+                return fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+        uint16_t *counts = context->counts + halo * width;
+
+        // Berechnung vorbereiten (bei Störungsrechnung inklusive des Referenzorbits)
+        render_view view = {
+            .r_start = request->r_start,
+            .i_start = request->i_start,
+            .resolution = request->resolution,
+            .max_iterations = request->max_iterations,
+            .width = width,
+            .height = height,
+        };
+        render_plan *plan = render_plan_create(&view, kernel, options->lanes, precision);
+        if (plan == NULL)
+                return fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+
+        // Der progressive Modus berechnet das ganze Bild und spiegelt nicht. Wird trotz
+        // options->mirror nicht gespiegelt, wird der Grund im Ergebnis gemeldet
+        uint64_t axis = options->mirror && !options->progressive ? render_plan_mirror_axis(plan) : 0;
+        const char *unmirrored = NULL;
+        if (options->mirror && axis == 0)
+        {
+                double row = (double)(-request->i_start / request->resolution);
+                if (options->progressive)
+                        unmirrored = "Im progressiven Modus wird nicht gespiegelt.";
+                else if (precision == PRECISION_PERTURBATION)
+                        unmirrored = "Mit Störungsrechnung wird nicht gespiegelt.";
+                else if (row < 0 || row >= (double)height)
+                        unmirrored = "Die reelle Achse liegt nicht im Bild.";
+                else if (fabs(row - round(row)) >= 0x1p-10)
+                        unmirrored = "Die reelle Achse liegt zwischen zwei Zeilen des Bildes.";
+                else
+                        unmirrored = "Die reelle Achse liegt zu nah am Bildrand.";
+        }
+
+        // Messwerte mit einer Zelle der Zeitkarte je Kachel
+        if (options->stats_path != NULL)
+        {
+                if (!render_stats_reset(&context->stats, width, height, options->tile_size))
+                {
+                        render_plan_destroy(plan);
+                        return fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+                }
+                render_plan_stats(plan, &context->stats);
+        }
+
+        // Im progressiven Modus steht das Bild danach vollständig in counts und
+        // wird unten nur noch geschrieben, gemeldet und überprüft
+        double time = 0;
+        if (options->progressive)
+        {
+                status = render_progressive(context, request, plan, counts, format, width, height, &time);
+                if (status != RENDER_OK)
+                {
+                        render_plan_destroy(plan);
+                        return status;
+                }
+        }
+
+        const char *file_name = request->sink.file_name;
+        unsigned file_count = file_name != NULL ? options->palette_count : 0;
+        image_writer *writers[PALETTE_COUNT] = {NULL};
+        palette *palettes[PALETTE_COUNT] = {NULL};
+        if (file_count > 0)
+        {
+                status = open_files(context, file_name, format, width, height, strip_height, request->max_iterations,
+                                    writers, palettes);
+                if (status != RENDER_OK)
+                {
+                        render_plan_destroy(plan);
+                        return status;
+                }
+        }
+
+        // Wenn noch genug Speicher reserviert werden kann, wird jeder Streifen
+        // (VERIFY_FULL) oder eine zufällige Auswahl seiner Zeilen (VERIFY_SAMPLED)
+        // zusätzlich mit dem Referenzprogramm berechnet. Bei der Stichprobe wird nur
+        // Platz für eine Zeile benötigt. Verglichen werden die Iterationszähler,
+        // nicht erst die Farben. Mit Störungsrechnung wird gegen die direkte
+        // Iteration in double verglichen
+        render_plan *reference = NULL;
+        if (options->verify != VERIFY_OFF &&
+            reserve(&context->comparison, &context->comparison_size,
+                    options->verify == VERIFY_FULL ? width * strip_height : width))
+        {
+                if (context->reference_pool == NULL)
+                        context->reference_pool = threadpool_create(1);
+                if (context->reference_pool != NULL)
+                        reference = render_plan_create(&view, KERNEL_C, LANES_GROUP,
+                                                       precision == PRECISION_FLOAT ? PRECISION_FLOAT : PRECISION_DOUBLE);
+        }
+        uint16_t *comparison = context->comparison;
+        _Bool verified = reference != NULL;
+
+        uint64_t hits_before = 0;
+        uint64_t misses_before = 0;
+        if (context->cache != NULL)
+                tile_cache_stats(context->cache, &hits_before, &misses_before);
+
+        // BMP Dateien beginnen mit der untersten Zeile (i_start), TIFF und PNG Dateien
+        // mit der obersten. Im zweiten Fall werden die Streifen von oben nach unten
+        // berechnet, damit die Dateien von vorne nach hinten gefüllt werden
+        _Bool bottom_up = file_count == 0 || image_writer_bottom_up(writers[0]);
+        uint64_t strips = (height + strip_height - 1) / strip_height;
+
+        // Gespiegelt wird die Hälfte der Zeilenpaare, die später berechnet würde. Ist
+        // für ihre Quellzeilen kein Speicher verfügbar, wird alles berechnet
+        struct mirror mirror = {.axis = axis, .first = 1, .last = 0};
+        if (axis > 0 && bottom_up)
+        {
+                mirror.first = axis / 2 + 1;
+                mirror.last = axis < height - 1 ? axis : height - 1;
+        }
+        else if (axis > 0)
+        {
+                mirror.first = axis > height - 1 ? axis - (height - 1) : 0;
+                mirror.last = (axis - 1) / 2;
+        }
+        if (mirror.first <= mirror.last &&
+            !reserve(&context->sources, &context->sources_size, (mirror.last - mirror.first + 1) * width))
+        {
+                mirror = (struct mirror){.first = 1, .last = 0};
+                unmirrored = "Für die gespiegelten Zeilen ist nicht genug Speicher verfügbar.";
+        }
+
+        uint64_t counter = 0;
+        uint64_t compared_rows = 0;
+        uint64_t supersampled = 0;
+        uint64_t random_state = (uint64_t)(curtime() * 1e9) | 1;
+        double c_time = 0;
+        status = RENDER_OK;
+        for (uint64_t strip = 0; strip < strips && status == RENDER_OK; strip++)
+        {
+                uint64_t y = (bottom_up ? strip : strips - 1 - strip) * strip_height;
+                uint64_t rows = height - y < strip_height ? height - y : strip_height;
+
+                // Messung der zur Ausführung benötigten Zeit und tatsächliche Ausführung der
+                // Berechnung durch die Assembly Implementierung. Der Streifen wird in Kacheln
+                // aufgeteilt, die sich die Worker gegenseitig stehlen, da die Kosten der
+                // Kacheln je nach Lage zur Mandelbrotmenge stark schwanken
+                double start = curtime();
+                if (!options->progressive)
+                {
+                        uint64_t below = y >= halo ? halo : 0;
+                        uint64_t above = height - y - rows >= halo ? halo : 0;
+                        render_rows(context, plan, &mirror, counts - below * width, width, y - below,
+                                    rows + below + above);
+                }
+
+                // Randpixel werden zusätzlich an grid x grid Stellen innerhalb des
+                // Pixels berechnet
+                const render_samples *samples = NULL;
+                if (antialias)
+                {
+                        if (!render_plan_supersample(context->pool, plan, counts, width, y, rows, options->antialias,
+                                                     &context->samples))
+                        {
+                                status = fail(context, RENDER_ERROR_MEMORY, "Es konnte nicht genug Speicherplatz allokiert werden.");
+                                break;
+                        }
+                        samples = &context->samples;
+                        supersampled += samples->row_start[rows];
+                }
+                time += curtime() - start;
+                if (options->stats_path != NULL)
+                        render_stats_histogram(&context->stats, counts, width, width, rows, request->max_iterations);
+
+                if (request->sink.tile != NULL &&
+                    !report_tiles(&request->sink, counts, width, y, rows, options->tile_size))
+                {
+                        status = fail(context, RENDER_ERROR_CANCELLED, "Die Berechnung wurde abgebrochen.");
+                        break;
+                }
+
+                // Einfärben der Zähler mit jedem Farbschema direkt in die Zeilen der Dateien
+                status = write_rows(context, format, writers, palettes, file_count, counts, width, y, rows, samples, &time);
+
+                if (reference == NULL || status != RENDER_OK)
+                        continue;
+
+                if (options->verify == VERIFY_FULL)
+                {
+                        // Berechnung der von Referenzprogramm benötigten Zeit und Ausführung
+                        // des Referenzprogrammes
+                        start = curtime();
+                        render_plan_rows(context->reference_pool, reference, NULL, comparison, width, y, rows,
+                                         options->tile_size, RENDER_MODE_SCAN);
+                        c_time += curtime() - start;
+                        counter += compare_counts(counts, comparison, width * rows);
+                        compared_rows += rows;
+                        continue;
+                }
+
+                // Stichprobe: Jede Zeile wird mit der Wahrscheinlichkeit sample_rate
+                // ausgewählt, mindestens jedoch eine Zeile pro Streifen
+                uint64_t sampled = 0;
+                for (uint64_t row = 0; row < rows; row++)
+                {
+                        if ((double)(random_next(&random_state) >> 11) * 0x1p-53 >= options->sample_rate)
+                                continue;
+                        render_plan_rows(context->reference_pool, reference, NULL, comparison, width, y + row, 1,
+                                         options->tile_size, RENDER_MODE_SCAN);
+                        counter += compare_counts(counts + row * width, comparison, width);
+                        sampled++;
+                }
+                if (sampled == 0)
+                {
+                        uint64_t row = random_next(&random_state) % rows;
+                        render_plan_rows(context->reference_pool, reference, NULL, comparison, width, y + row, 1,
+                                         options->tile_size, RENDER_MODE_SCAN);
+                        counter += compare_counts(counts + row * width, comparison, width);
+                        sampled++;
+                }
+                compared_rows += sampled;
+        }
+        render_plan_destroy(plan);
+        render_plan_destroy(reference);
+
+        // Beim Schließen werden die letzten PNG Zeilen noch auf dem Threadpool
+        // komprimiert
+        status = finish_files(context, writers, palettes, file_count, status);
+        if (status == RENDER_OK && options->stats_path != NULL)
+        {
+                context->stats.render_time = time - context->stats.color_time;
+                if (!write_cell_times(&context->stats, options->stats_path))
+                        status = fail(context, RENDER_ERROR_FILE, "Die Datei %s konnte nicht geschrieben werden.",
+                                      options->stats_path);
+        }
+        if (status != RENDER_OK)
+                return status;
+
+        *result = (render_result){
+            .width = width,
+            .height = height,
+            .kernel = kernel,
+            .precision = precision,
+            .time = time,
+            .reference_time = c_time,
+            .verified = verified,
+            .compared_rows = compared_rows,
+            .mismatches = counter,
+            .cached = context->cache != NULL,
+            .file_count = file_count,
+            .supersampled = supersampled,
+            .mirrored = mirror.first <= mirror.last ? mirror.last - mirror.first + 1 : 0,
+            .unmirrored = unmirrored,
+            .stats = options->stats_path != NULL ? &context->stats : NULL,
+        };
+        if (context->cache != NULL)
+        {
+                tile_cache_stats(context->cache, &result->cache_hits, &result->cache_misses);
+                result->cache_hits -= hits_before;
+                result->cache_misses -= misses_before;
+        }
+        for (unsigned p = 0; p < file_count; p++)
+                result->paths[p] = context->paths[p];
+        return RENDER_OK;
+}
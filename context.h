@@ -0,0 +1,114 @@
+// Include Guards
+#ifndef CONTEXT_H
+#define CONTEXT_H
+#include <stddef.h>
+#include <stdint.h>
+#include "render.h"
+
+// Ergebnis einer Berechnung. Bei einem Fehler beschreibt render_context_error die
+// Ursache genauer
+typedef enum
+{
+        RENDER_OK,
+        RENDER_ERROR_INPUT,     // Resolution, Iterationen oder Ausschnitt ungültig
+        RENDER_ERROR_SIZE,      // Bild leer oder größer als RENDER_MAX_IMAGE_SIZE
+        RENDER_ERROR_FORMAT,    // Bild im gewählten Dateiformat nicht darstellbar
+        RENDER_ERROR_KERNEL,    // Kernel vom Prozessor nicht unterstützt
+        RENDER_ERROR_MEMORY,    // Speicher nicht verfügbar
+        RENDER_ERROR_FILE,      // Datei konnte nicht erstellt oder geschrieben werden
+        RENDER_ERROR_CANCELLED, // Abbruch durch den Kachel-Callback
+} render_status;
+
+// Maximale Größe der Pixeldaten eines Bildes in Byte (1 TiB). Bilder werden in
+// Streifen berechnet, daher begrenzt dieser Wert nur die Dateigröße
+#define RENDER_MAX_IMAGE_SIZE (1ULL << 40)
+
+// Fertig berechnete Kachel. Die Zähler der Zeile y + n beginnen bei counts + n * stride
+// und sind nur während des Callbacks gültig. Zeile 0 liegt bei i_start
+typedef struct
+{
+        uint64_t x;
+        uint64_t y;
+        uint64_t width;
+        uint64_t height;
+        const uint16_t *counts;
+        size_t stride;
+} render_tile;
+
+// Callback für jede fertige Kachel. Wird im Thread des Aufrufers von
+// render_context_run aufgerufen, sobald der Streifen der Kachel berechnet ist. Gibt
+// der Callback 0 zurück, wird die Berechnung abgebrochen
+typedef _Bool (*render_tile_fn)(void *user, const render_tile *tile);
+
+// Callback nach jedem Durchlauf des progressiven Modus (s. render_plan_pass). image
+// enthält die Vorschau des ganzen Bildes, pass zählt von 0 bis RENDER_PASSES - 1. Gibt
+// der Callback 0 zurück, wird die Berechnung abgebrochen
+typedef _Bool (*render_pass_fn)(void *user, unsigned pass, const render_tile *image);
+
+// Ziel der Ergebnisse. Alle Angaben sind optional und lassen sich kombinieren
+typedef struct
+{
+        const char *file_name; // Dateiname ohne Endung, je Farbschema eine Datei (NULL: keine)
+        render_tile_fn tile;   // Aufruf je fertiger Kachel (NULL: keiner)
+        render_pass_fn pass;   // Aufruf je progressivem Durchlauf (NULL: keiner)
+        void *user;            // Wird an tile und pass durchgereicht
+} render_sink;
+
+// Auftrag für eine Berechnung
+typedef struct
+{
+        hp_float r_start;
+        hp_float r_end;
+        hp_float i_start;
+        hp_float i_end;
+        double resolution;
+        int16_t max_iterations;
+        render_sink sink;
+} render_request;
+
+// Kennzahlen einer erfolgreichen Berechnung
+typedef struct
+{
+        uint64_t width;             // Bildgröße in Pixeln
+        uint64_t height;
+        kernel_variant kernel;      // Verwendeter Kernel
+        precision_tier precision;   // Verwendete Genauigkeitsstufe
+        double time;                // Dauer von Berechnung und Einfärben in Sekunden
+        double reference_time;      // Dauer der Referenzberechnung bei VERIFY_FULL
+        _Bool verified;             // Gibt an, ob mit der Referenz verglichen wurde
+        uint64_t compared_rows;     // Verglichene Zeilen
+        uint64_t mismatches;        // Davon abweichende Pixel
+        _Bool cached;               // Gibt an, ob der Kachel-Cache verfügbar war
+        uint64_t cache_hits;        // Aus dem Cache übernommene Kacheln dieses Auftrags
+        uint64_t cache_misses;      // Neu berechnete Kacheln dieses Auftrags
+        uint64_t supersampled;      // Mit zusätzlichen Stichproben geglättete Randpixel
+        uint64_t mirrored;          // An der reellen Achse gespiegelte statt berechnete Zeilen
+        const char *unmirrored;     // Grund, warum trotz options.mirror nicht gespiegelt wurde (sonst NULL)
+        const render_stats *stats;  // Messwerte bei options.stats_path (sonst NULL), gültig bis zum nächsten Auftrag
+        unsigned file_count;        // Anzahl der geschriebenen Dateien
+        const char *paths[PALETTE_COUNT]; // Pfade der Dateien, gültig bis zum nächsten Auftrag
+} render_result;
+
+// Undurchsichtiger Typ eines wiederverwendbaren Rechenkontexts (s. context.c). Er
+// besitzt den Threadpool, die Puffer und den Kachel-Cache und darf nur von einem
+// Thread gleichzeitig verwendet werden
+typedef struct render_context render_context;
+
+// render_context_create: Erstellt einen Kontext mit den Einstellungen options. Die
+// Farbschemata und der Pfad des Caches werden übernommen. Gibt NULL zurück, falls
+// kein Speicher verfügbar ist. Ein nicht verfügbarer Cache ist kein Fehler
+render_context *render_context_create(const render_options *options);
+
+// render_context_run: Berechnet den Auftrag in Streifen, meldet jede fertige Kachel an
+// den Callback und schreibt die Dateien. Im progressiven Modus wird das ganze Bild in
+// RENDER_PASSES Durchläufen berechnet und nach jedem Durchlauf eine Vorschau gemeldet
+// und geschrieben. Puffer bleiben für weitere Aufträge erhalten. result darf NULL sein
+render_status render_context_run(render_context *context, const render_request *request, render_result *result);
+
+// render_context_error: Beschreibung des letzten Fehlers als vollständiger Satz
+const char *render_context_error(const render_context *context);
+
+// render_context_destroy: Schließt den Cache und gibt den Kontext frei
+void render_context_destroy(render_context *context);
+
+#endif // !CONTEXT_H
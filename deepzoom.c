@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <quadmath.h>
+#include "deepzoom.h"
+#include "mandelbrot.h"
+
+hp_float hp_parse(const char *text)
+{
+        return strtoflt128(text, NULL);
+}
+
+reference_orbit *reference_orbit_create(hp_float r, hp_float i, int16_t max_iterations)
+{
+        reference_orbit *orbit = malloc(sizeof(*orbit));
+        if (orbit == NULL)
+                return NULL;
+        size_t entries = (max_iterations > 0 ? (size_t)max_iterations : 0) + 1;
+        orbit->re = malloc(entries * sizeof(double));
+        orbit->im = malloc(entries * sizeof(double));
+        if (orbit->re == NULL || orbit->im == NULL)
+        {
+                reference_orbit_destroy(orbit);
+                return NULL;
+        }
+
+        // Der Orbit wird bis einschließlich des ersten Wertes außerhalb des
+        // Kreises mit Radius 2 gespeichert, damit Pixel ihn bis zu dieser
+        // Stelle verwenden können
+        hp_float last_Re = 0, last_Im = 0;
+        uint64_t n = 0;
+        orbit->re[0] = 0;
+        orbit->im[0] = 0;
+        while (n < entries - 1)
+        {
+                hp_float tmp_Re = last_Re;
+                last_Re = tmp_Re * tmp_Re - last_Im * last_Im + r;
+                last_Im = 2 * tmp_Re * last_Im + i;
+                n++;
+                orbit->re[n] = (double)last_Re;
+                orbit->im[n] = (double)last_Im;
+                if (!(last_Re * last_Re + last_Im * last_Im < 4))
+                        break;
+        }
+        orbit->length = n;
+        return orbit;
+}
+
+void reference_orbit_destroy(reference_orbit *orbit)
+{
+        if (orbit == NULL)
+                return;
+        free(orbit->re);
+        free(orbit->im);
+        free(orbit);
+}
+
+// Die Abweichung δ wird zurückgesetzt (Rebasing), sobald der Pixelorbit z = Z + δ
+// betragsmäßig kleiner als δ wird. Ab dieser Stelle ist δ gegenüber Z nicht mehr
+// klein und die Störungsrechnung würde Fehler ansammeln ("Glitch"). Da Z_0 = 0 ist,
+// wird dann mit δ = z am Anfang des Referenzorbits weitergerechnet. Dasselbe gilt,
+// wenn der Referenzorbit früher als das Pixel flieht und sein Ende erreicht ist
+void mandelbrot_perturbation_tile(const reference_orbit *orbit, double ref_x, double ref_y, double resolution,
+                                  uint16_t *counts, int16_t max_iterations,
+                                  uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride)
+{
+        const double *Z_re = orbit->re;
+        const double *Z_im = orbit->im;
+        for (uint64_t row = 0; row < height; row++)
+        {
+                double dc_Im = ((double)(y + row) - ref_y) * resolution;
+                uint16_t *count = counts + row * stride;
+                for (uint64_t column = 0; column < width; column++)
+                {
+                        double dc_Re = ((double)(x + column) - ref_x) * resolution;
+                        double d_Re = 0, d_Im = 0;
+                        uint64_t m = 0;
+                        int16_t iteration_counter = 0;
+
+                        // Z_1 ist der Referenzpunkt selbst, daher ist Z_1 + δc der Pixelpunkt
+                        if (orbit->length > 0 && mandelbrot_c_interior_double(Z_re[1] + dc_Re, Z_im[1] + dc_Im))
+                                iteration_counter = max_iterations;
+
+                        // Zustand des Pixels zur Zyklenerkennung nach Brent
+                        double saved_Re = 0, saved_Im = 0;
+                        uint64_t saved_m = 0;
+                        while (iteration_counter < max_iterations)
+                        {
+                                // δ_n+1 = 2 Z_n δ_n + δ_n² + δc
+                                double tmp_Re = d_Re;
+                                d_Re = 2 * (Z_re[m] * tmp_Re - Z_im[m] * d_Im) + (tmp_Re * tmp_Re - d_Im * d_Im) + dc_Re;
+                                d_Im = 2 * (Z_re[m] * d_Im + Z_im[m] * tmp_Re) + 2 * tmp_Re * d_Im + dc_Im;
+                                m++;
+
+                                double z_Re = Z_re[m] + d_Re;
+                                double z_Im = Z_im[m] + d_Im;
+                                double magnitude = z_Re * z_Re + z_Im * z_Im;
+                                if (!(magnitude < 4))
+                                        break;
+                                iteration_counter++;
+
+                                if (magnitude < d_Re * d_Re + d_Im * d_Im || m == orbit->length)
+                                {
+                                        d_Re = z_Re;
+                                        d_Im = z_Im;
+                                        m = 0;
+                                }
+
+                                // Wiederholt sich (δ, m) exakt, ist die Bahn periodisch
+                                if (d_Re == saved_Re && d_Im == saved_Im && m == saved_m)
+                                {
+                                        iteration_counter = max_iterations;
+                                        break;
+                                }
+                                if (!(iteration_counter & (iteration_counter - 1)))
+                                {
+                                        saved_Re = d_Re;
+                                        saved_Im = d_Im;
+                                        saved_m = m;
+                                }
+                        }
+                        count[column] = iteration_counter;
+                }
+        }
+}
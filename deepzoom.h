@@ -0,0 +1,39 @@
+// Include Guards
+#ifndef DEEPZOOM_H
+#define DEEPZOOM_H
+#include <stddef.h>
+#include <stdint.h>
+
+// Gleitkommatyp mit vierfacher Genauigkeit (113 Bit Mantisse) für Koordinaten,
+// die bei tiefen Zooms nicht mehr als double darstellbar sind
+typedef __float128 hp_float;
+
+// hp_parse: Liest eine Dezimalzahl mit voller vierfacher Genauigkeit ein
+hp_float hp_parse(const char *text);
+
+// Referenzorbit Z_0 = 0, Z_n+1 = Z_n² + C eines einzelnen Punktes C. Der Orbit
+// wird mit vierfacher Genauigkeit berechnet und als double gespeichert, da für
+// die Störungsrechnung nur die Abweichungen der Pixel genau sein müssen
+typedef struct
+{
+        double *re;      // Realteile Z_0 bis Z_length
+        double *im;      // Imaginärteile Z_0 bis Z_length
+        uint64_t length; // Index des letzten Eintrags (Flucht oder maximale Iterationen)
+} reference_orbit;
+
+// reference_orbit_create: Berechnet den Orbit von C = r + i*i bis zur Flucht
+// oder bis max_iterations. Gibt NULL zurück, falls kein Speicher verfügbar ist
+reference_orbit *reference_orbit_create(hp_float r, hp_float i, int16_t max_iterations);
+
+// reference_orbit_destroy: Gibt den Speicher eines Orbits frei
+void reference_orbit_destroy(reference_orbit *orbit);
+
+// mandelbrot_perturbation_tile: Berechnet die Pixel [x;x+width) x [y;y+height)
+// relativ zum Referenzpunkt, der im Gesamtbild bei (ref_x, ref_y) liegt. Jedes
+// Pixel wird als Abweichung δ vom Referenzorbit iteriert:
+//   δ_n+1 = 2 Z_n δ_n + δ_n² + δc
+void mandelbrot_perturbation_tile(const reference_orbit *orbit, double ref_x, double ref_y, double resolution,
+                                  uint16_t *counts, int16_t max_iterations,
+                                  uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+#endif // !DEEPZOOM_H
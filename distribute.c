@@ -0,0 +1,823 @@
+#include <inttypes.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "context.h"
+#include "distribute.h"
+#include "timer.h"
+
+// Kennungen der Nachrichten ("MBS1", "MBR1"). Die Strukturen werden unverändert
+// übertragen, Koordinator und Worker müssen daher für x86-64 übersetzt sein
+#define REQUEST_MAGIC 0x3153424dU
+#define REPLY_MAGIC 0x3152424dU
+
+// Streifen je Worker. Mehrere kleinere Streifen gleichen Fehler der Kostenschätzung
+// und unterschiedlich schnelle Worker aus
+#define STRIPS_PER_WORKER 8
+
+// Maximale Anzahl der Zähler eines Streifens (32 MiB). Einzelne Zeilen dürfen länger sein
+#define MAX_STRIP_COUNTS (16ULL << 20)
+
+// Höchstens so viele Spalten hat das grobe Raster der Kostenschätzung
+#define PROBE_COLUMNS 256
+
+// Ein Streifen wird ein zweites Mal vergeben, wenn er SLOW_FACTOR mal länger läuft, als
+// seine Kosten bei der bisherigen Geschwindigkeit der fertigen Streifen erwarten lassen
+#define SLOW_FACTOR 3
+
+// Fehlgeschlagene Versuche in Folge, nach denen ein Worker als ausgefallen gilt
+#define MAX_FAILURES 3
+
+// Auftrag des Koordinators: Zeilen [y;y+rows) des Bildes width x height
+struct strip_request
+{
+        uint32_t magic;
+        uint32_t precision;
+        int32_t max_iterations;
+        uint32_t reserved;
+        hp_float r_start;
+        hp_float i_start;
+        double resolution;
+        uint64_t width;
+        uint64_t height;
+        uint64_t y;
+        uint64_t rows;
+        uint64_t reserved_end;
+};
+
+// Antwort des Workers, gefolgt von size Byte mit zlib komprimierten Zählern
+struct strip_reply
+{
+        uint32_t magic;
+        uint32_t reserved;
+        uint64_t y;
+        uint64_t rows;
+        uint64_t size;
+};
+
+// Zustand eines Streifens beim Koordinator
+typedef enum
+{
+        STRIP_OPEN,
+        STRIP_RUNNING,
+        STRIP_DONE,
+} strip_state;
+
+struct strip
+{
+        uint64_t y;
+        uint64_t rows;
+        double cost;      // Geschätzte Iterationen
+        strip_state state;
+        unsigned runners; // Verbindungen, die den Streifen gerade berechnen
+        _Bool backup;     // Bereits ein zweites Mal vergeben
+        double started;
+};
+
+struct coordinator
+{
+        // Alle folgenden Felder sind durch lock geschützt. changed wird nach jedem
+        // fertigen oder fehlgeschlagenen Streifen signalisiert
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+        struct strip *strips;
+        uint64_t strip_count;
+        uint64_t done;
+        unsigned alive;
+        _Bool finished;
+        _Bool failed;
+        double done_cost; // Kosten und Dauer der fertigen Streifen
+        double done_time;
+        uint64_t requeued;
+        uint64_t backups;
+
+        struct strip_request request; // Vorlage aller Aufträge
+        unsigned timeout;
+        image_format format;
+        image_writer *writers[PALETTE_COUNT];
+        palette *palettes[PALETTE_COUNT];
+        unsigned file_count;
+};
+
+// Verbindung des Koordinators zu einem Worker mit eigenen Puffern
+struct remote
+{
+        pthread_t thread;
+        struct coordinator *coordinator;
+        char *host;
+        char *port;
+        int fd; // -1: nicht verbunden, durch coordinator->lock geschützt
+        _Bool started;
+        _Bool dead;
+        uint64_t strips;
+        double busy;
+        uint16_t *counts;
+        size_t count_capacity;
+        unsigned char *data;
+        size_t data_capacity;
+};
+
+// send_all: Sendet size Byte vollständig. Gibt 0 zurück, falls die Verbindung getrennt wurde
+static _Bool send_all(int fd, const void *buffer, size_t size)
+{
+        const unsigned char *data = buffer;
+        while (size > 0)
+        {
+                ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+                if (sent <= 0)
+                        return 0;
+                data += sent;
+                size -= (size_t)sent;
+        }
+        return 1;
+}
+
+// recv_all: Empfängt genau size Byte. Gibt 0 zurück, falls die Verbindung getrennt
+// wurde oder die Wartezeit abgelaufen ist
+static _Bool recv_all(int fd, void *buffer, size_t size)
+{
+        unsigned char *data = buffer;
+        while (size > 0)
+        {
+                ssize_t received = recv(fd, data, size, 0);
+                if (received <= 0)
+                        return 0;
+                data += received;
+                size -= (size_t)received;
+        }
+        return 1;
+}
+
+// reserve: Vergrößert einen Puffer auf mindestens size Byte
+static _Bool reserve(void **buffer, size_t *capacity, size_t size)
+{
+        if (size <= *capacity)
+                return 1;
+        void *grown = realloc(*buffer, size);
+        if (grown == NULL)
+                return 0;
+        *buffer = grown;
+        *capacity = size;
+        return 1;
+}
+
+// same_view: Prüft, ob zwei Aufträge denselben Ausschnitt betreffen
+static _Bool same_view(const struct strip_request *a, const struct strip_request *b)
+{
+        return a->precision == b->precision && a->max_iterations == b->max_iterations && a->r_start == b->r_start &&
+               a->i_start == b->i_start && a->resolution == b->resolution && a->width == b->width &&
+               a->height == b->height;
+}
+
+// valid_request: Prüft einen empfangenen Auftrag, bevor Speicher für ihn reserviert wird
+static _Bool valid_request(const struct strip_request *request)
+{
+        return request->magic == REQUEST_MAGIC && request->precision >= PRECISION_FLOAT &&
+               request->precision <= PRECISION_PERTURBATION && request->max_iterations >= 0 &&
+               request->max_iterations <= INT16_MAX && request->resolution > 0 && request->width > 0 &&
+               request->width % 4 == 0 && request->rows > 0 && request->y < request->height &&
+               request->rows <= request->height - request->y &&
+               (request->rows == 1 || request->width * request->rows <= MAX_STRIP_COUNTS);
+}
+
+// open_listener: Öffnet den Socket auf address:port. Gibt -1 zurück, falls die
+// Adresse ungültig oder der Port nicht verfügbar ist
+static int open_listener(const char *address, unsigned port)
+{
+        char service[16];
+        snprintf(service, sizeof(service), "%u", port);
+        struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_PASSIVE};
+        struct addrinfo *addresses;
+        if (getaddrinfo(address, service, &hints, &addresses))
+                return -1;
+        int fd = -1;
+        for (struct addrinfo *a = addresses; a != NULL && fd < 0; a = a->ai_next)
+        {
+                fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                if (fd < 0)
+                        continue;
+                int reuse = 1;
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+                if (bind(fd, a->ai_addr, a->ai_addrlen) || listen(fd, 8))
+                {
+                        close(fd);
+                        fd = -1;
+                }
+        }
+        freeaddrinfo(addresses);
+        return fd;
+}
+
+// serve_coordinator: Beantwortet die Aufträge einer Verbindung, bis sie getrennt wird
+// oder ein ungültiger Auftrag eintrifft. Der Plan des letzten Ausschnitts bleibt
+// erhalten, bei Störungsrechnung also auch der Referenzorbit
+static void serve_coordinator(int fd, threadpool *pool, const render_options *options, render_plan **plan,
+                              struct strip_request *planned, uint16_t **counts, size_t *count_capacity,
+                              unsigned char **data, size_t *data_capacity)
+{
+        struct strip_request request;
+        while (recv_all(fd, &request, sizeof(request)) && valid_request(&request))
+        {
+                double start = curtime();
+                if (*plan == NULL || !same_view(&request, planned))
+                {
+                        render_plan_destroy(*plan);
+                        render_view view = {
+                            .r_start = request.r_start,
+                            .i_start = request.i_start,
+                            .resolution = request.resolution,
+                            .max_iterations = (int16_t)request.max_iterations,
+                            .width = request.width,
+                            .height = request.height,
+                        };
+                        *plan = render_plan_create(&view, options->kernel, options->lanes, (precision_tier)request.precision);
+                        *planned = request;
+                }
+
+                size_t bytes = request.width * request.rows * sizeof(uint16_t);
+                uLongf size = compressBound(bytes);
+                if (*plan == NULL || !reserve((void **)counts, count_capacity, bytes) ||
+                    !reserve((void **)data, data_capacity, size))
+                {
+                        fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                        fflush(stderr);
+                        return;
+                }
+                render_plan_rows(pool, *plan, NULL, *counts, request.width, request.y, request.rows, options->tile_size,
+                                 options->mode);
+
+                // Zähler benachbarter Pixel sind oft gleich und lassen sich stark komprimieren
+                struct strip_reply reply = {.magic = REPLY_MAGIC, .y = request.y, .rows = request.rows};
+                if (compress2(*data, &size, (const Bytef *)*counts, bytes, 1) != Z_OK)
+                        return;
+                reply.size = size;
+                if (!send_all(fd, &reply, sizeof(reply)) || !send_all(fd, *data, size))
+                        return;
+                printf("   Zeilen %" PRIu64 " bis %" PRIu64 " in %f Sekunden berechnet.\r\n", request.y,
+                       request.y + request.rows - 1, curtime() - start);
+                fflush(stdout);
+        }
+}
+
+int distribute_worker(const render_options *options, const distribute_settings *settings)
+{
+        kernel_variant kernel = kernel_resolve(options->kernel);
+        if (!kernel_supported(kernel))
+        {
+                fprintf(stderr, "   Der Kernel %s wird von diesem Prozessor nicht unterstützt.\r\n", kernel_name(kernel));
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        int listener = settings->port > 0 && settings->port <= 65535 ? open_listener(settings->listen, settings->port) : -1;
+        if (listener < 0)
+        {
+                fprintf(stderr, "   Der Port %s:%u konnte nicht geöffnet werden.\r\n", settings->listen, settings->port);
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        threadpool *pool = threadpool_create(options->threads);
+        if (pool == NULL)
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+                close(listener);
+                return EXIT_FAILURE;
+        }
+        printf("   Worker läuft auf %s:%u (%u Threads, Kernel %s).\r\n", settings->listen, settings->port,
+               options->threads, kernel_name(kernel));
+        fflush(stdout);
+
+        // Koordinatoren werden nacheinander bedient, jeder Streifen nutzt alle Threads
+        render_plan *plan = NULL;
+        struct strip_request planned = {0};
+        uint16_t *counts = NULL;
+        size_t count_capacity = 0;
+        unsigned char *data = NULL;
+        size_t data_capacity = 0;
+        for (;;)
+        {
+                int fd = accept(listener, NULL, NULL);
+                if (fd < 0)
+                        continue;
+                serve_coordinator(fd, pool, options, &plan, &planned, &counts, &count_capacity, &data, &data_capacity);
+                close(fd);
+        }
+}
+
+// remote_connect: Verbindet sich mit dem Worker. Ist der Koordinator inzwischen
+// fertig, wird die Verbindung sofort wieder geschlossen
+static _Bool remote_connect(struct remote *remote)
+{
+        struct coordinator *coordinator = remote->coordinator;
+        struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+        struct addrinfo *addresses;
+        if (getaddrinfo(remote->host, remote->port, &hints, &addresses))
+                return 0;
+        int fd = -1;
+        for (struct addrinfo *a = addresses; a != NULL && fd < 0; a = a->ai_next)
+        {
+                fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen))
+                {
+                        close(fd);
+                        fd = -1;
+                }
+        }
+        freeaddrinfo(addresses);
+        if (fd < 0)
+                return 0;
+
+        // Ein Worker, der länger als timeout nicht antwortet, gilt als ausgefallen
+        struct timeval timeout = {.tv_sec = coordinator->timeout};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        pthread_mutex_lock(&coordinator->lock);
+        _Bool finished = coordinator->finished;
+        if (!finished)
+                remote->fd = fd;
+        pthread_mutex_unlock(&coordinator->lock);
+        if (finished)
+                close(fd);
+        return !finished;
+}
+
+// remote_disconnect: Schließt die Verbindung zum Worker
+static void remote_disconnect(struct remote *remote)
+{
+        pthread_mutex_lock(&remote->coordinator->lock);
+        if (remote->fd >= 0)
+                close(remote->fd);
+        remote->fd = -1;
+        pthread_mutex_unlock(&remote->coordinator->lock);
+}
+
+// next_strip: Vergibt den nächsten offenen Streifen. Sind alle vergeben, wird ein
+// ungewöhnlich lange laufender Streifen ein zweites Mal vergeben oder gewartet. Gibt
+// NULL zurück, sobald alle Streifen fertig sind
+static struct strip *next_strip(struct coordinator *coordinator)
+{
+        pthread_mutex_lock(&coordinator->lock);
+        struct strip *next = NULL;
+        while (next == NULL && !coordinator->finished && coordinator->done < coordinator->strip_count)
+        {
+                double now = curtime();
+                for (uint64_t s = 0; s < coordinator->strip_count && next == NULL; s++)
+                {
+                        if (coordinator->strips[s].state == STRIP_OPEN)
+                                next = &coordinator->strips[s];
+                }
+
+                // Die erwartete Dauer ergibt sich aus der Geschwindigkeit der fertigen Streifen
+                for (uint64_t s = 0; s < coordinator->strip_count && next == NULL && coordinator->done_cost > 0; s++)
+                {
+                        struct strip *strip = &coordinator->strips[s];
+                        double expected = strip->cost * coordinator->done_time / coordinator->done_cost;
+                        if (strip->state == STRIP_RUNNING && !strip->backup && now - strip->started > SLOW_FACTOR * expected)
+                        {
+                                strip->backup = 1;
+                                coordinator->backups++;
+                                next = strip;
+                        }
+                }
+
+                if (next == NULL)
+                {
+                        struct timespec until;
+                        clock_gettime(CLOCK_REALTIME, &until);
+                        until.tv_nsec += 100000000;
+                        until.tv_sec += until.tv_nsec / 1000000000;
+                        until.tv_nsec %= 1000000000;
+                        pthread_cond_timedwait(&coordinator->changed, &coordinator->lock, &until);
+                }
+        }
+        if (next != NULL)
+        {
+                if (next->state == STRIP_OPEN)
+                        next->started = curtime();
+                next->state = STRIP_RUNNING;
+                next->runners++;
+        }
+        pthread_mutex_unlock(&coordinator->lock);
+        return next;
+}
+
+// finish_strip: Meldet das Ende einer Berechnung. War sie erfolgreich und der Streifen
+// noch nicht fertig, gibt sie ihm die Zeilen der Dateien in pixels und strides zurück,
+// die der Aufrufer danach füllt. Ist kein Worker mehr mit einem fehlgeschlagenen
+// Streifen beschäftigt, wird er wieder offen. Gibt 1 zurück, falls der Aufrufer die
+// Zeilen schreiben soll
+static _Bool finish_strip(struct coordinator *coordinator, struct strip *strip, _Bool computed, double time,
+                          unsigned char **pixels, ptrdiff_t *strides)
+{
+        pthread_mutex_lock(&coordinator->lock);
+        strip->runners--;
+        _Bool write = computed && strip->state != STRIP_DONE;
+        if (write)
+        {
+                strip->state = STRIP_DONE;
+                coordinator->done++;
+                coordinator->done_cost += strip->cost;
+                coordinator->done_time += time;
+                for (unsigned p = 0; p < coordinator->file_count; p++)
+                {
+                        pixels[p] = image_writer_rows(coordinator->writers[p], strip->y, strip->rows, &strides[p]);
+                        if (pixels[p] == NULL)
+                        {
+                                coordinator->failed = 1;
+                                write = 0;
+                        }
+                }
+        }
+        else if (strip->state != STRIP_DONE && strip->runners == 0)
+        {
+                strip->state = STRIP_OPEN;
+                coordinator->requeued++;
+        }
+        pthread_cond_broadcast(&coordinator->changed);
+        pthread_mutex_unlock(&coordinator->lock);
+        return write;
+}
+
+// remote_strip: Lässt den Worker einen Streifen berechnen und empfängt dessen Zähler
+// nach remote->counts. Gibt 0 zurück, falls die Verbindung abbricht oder die Antwort
+// ungültig ist
+static _Bool remote_strip(struct remote *remote, const struct strip *strip)
+{
+        struct coordinator *coordinator = remote->coordinator;
+        struct strip_request request = coordinator->request;
+        request.y = strip->y;
+        request.rows = strip->rows;
+        if (!send_all(remote->fd, &request, sizeof(request)))
+                return 0;
+
+        struct strip_reply reply;
+        size_t bytes = request.width * request.rows * sizeof(uint16_t);
+        if (!recv_all(remote->fd, &reply, sizeof(reply)) || reply.magic != REPLY_MAGIC || reply.y != strip->y ||
+            reply.rows != strip->rows || reply.size > compressBound(bytes))
+                return 0;
+        if (!reserve((void **)&remote->data, &remote->data_capacity, reply.size) ||
+            !reserve((void **)&remote->counts, &remote->count_capacity, bytes) ||
+            !recv_all(remote->fd, remote->data, reply.size))
+                return 0;
+        uLongf length = bytes;
+        return uncompress((Bytef *)remote->counts, &length, remote->data, reply.size) == Z_OK && length == bytes;
+}
+
+// wait_retry: Wartet vor einem neuen Versuch eine Sekunde, außer der Koordinator ist
+// inzwischen fertig
+static void wait_retry(struct coordinator *coordinator)
+{
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += 1;
+        pthread_mutex_lock(&coordinator->lock);
+        while (!coordinator->finished &&
+               pthread_cond_timedwait(&coordinator->changed, &coordinator->lock, &until) == 0)
+                ;
+        pthread_mutex_unlock(&coordinator->lock);
+}
+
+// remote_main: Berechnet Streifen auf einem Worker, bis alle fertig sind oder der
+// Worker MAX_FAILURES mal in Folge nicht erreichbar war oder nicht antwortete
+static void *remote_main(void *arg)
+{
+        struct remote *remote = arg;
+        struct coordinator *coordinator = remote->coordinator;
+        uint64_t width = coordinator->request.width;
+        unsigned failures = 0;
+        struct strip *strip;
+        while (failures < MAX_FAILURES && (strip = next_strip(coordinator)) != NULL)
+        {
+                double start = curtime();
+                unsigned char *pixels[PALETTE_COUNT];
+                ptrdiff_t strides[PALETTE_COUNT];
+                _Bool computed = (remote->fd >= 0 || remote_connect(remote)) && remote_strip(remote, strip);
+                double time = curtime() - start;
+                if (!finish_strip(coordinator, strip, computed, time, pixels, strides))
+                {
+                        if (!computed)
+                        {
+                                remote_disconnect(remote);
+                                failures++;
+                                wait_retry(coordinator);
+                        }
+                        continue;
+                }
+                failures = 0;
+                remote->strips++;
+                remote->busy += time;
+
+                // Einfärben direkt in die Zeilen der Dateien, andere Verbindungen
+                // schreiben gleichzeitig in andere Zeilen
+                for (unsigned p = 0; p < coordinator->file_count; p++)
+                {
+                        if (image_format_indexed(coordinator->format))
+                                palette_index_rows(coordinator->palettes[p], remote->counts, width, pixels[p], strides[p],
+                                                   width, strip->rows);
+                        else
+                                palette_apply_rows(coordinator->palettes[p], remote->counts, width, pixels[p], strides[p],
+                                                   width, strip->rows);
+                }
+        }
+        remote_disconnect(remote);
+
+        pthread_mutex_lock(&coordinator->lock);
+        remote->dead = failures >= MAX_FAILURES;
+        coordinator->alive--;
+        pthread_cond_broadcast(&coordinator->changed);
+        pthread_mutex_unlock(&coordinator->lock);
+        return NULL;
+}
+
+// split_strips: Schätzt die Kosten jeder Zeile an einem groben Raster mit höchstens
+// PROBE_COLUMNS Spalten und teilt das Bild in count Streifen etwa gleicher Kosten.
+// Jeder Pixel kostet zusätzlich eine Iteration, damit auch Bereiche ohne Iterationen
+// aufgeteilt werden. Gibt die Anzahl der Streifen oder 0 zurück, falls kein Speicher
+// verfügbar ist
+static uint64_t split_strips(const render_view *view, const render_options *options, kernel_variant kernel,
+                             precision_tier precision, uint64_t count, struct strip **strips)
+{
+        uint64_t step = (view->width + PROBE_COLUMNS - 1) / PROBE_COLUMNS;
+        render_view probe = *view;
+        probe.resolution *= (double)step;
+        probe.width = ((view->width + step - 1) / step + 3) / 4 * 4;
+        probe.height = (view->height + step - 1) / step;
+
+        double *row_cost = calloc(probe.height, sizeof(double));
+        uint16_t *counts = malloc(probe.width * probe.height * sizeof(uint16_t));
+        render_plan *plan = render_plan_create(&probe, kernel, options->lanes, precision);
+        threadpool *pool = threadpool_create(options->threads);
+        uint64_t max_rows = MAX_STRIP_COUNTS / view->width > 0 ? MAX_STRIP_COUNTS / view->width : 1;
+        uint64_t capacity = count + view->height / max_rows + 1;
+        *strips = calloc(capacity, sizeof(struct strip));
+        _Bool allocated = row_cost != NULL && counts != NULL && plan != NULL && pool != NULL && *strips != NULL;
+        uint64_t strip_count = 0;
+        if (allocated)
+        {
+                render_plan_rows(pool, plan, NULL, counts, probe.width, 0, probe.height, options->tile_size, options->mode);
+                double total = 0;
+                for (uint64_t row = 0; row < probe.height; row++)
+                {
+                        for (uint64_t x = 0; x < probe.width; x++)
+                                row_cost[row] += counts[row * probe.width + x] + 1;
+                        row_cost[row] /= (double)step;
+                        total += row_cost[row] * (double)step;
+                }
+
+                // Ein Streifen endet, sobald er sein Kostenziel oder die maximale Größe erreicht
+                double target = total / (double)count;
+                struct strip *strip = &(*strips)[0];
+                for (uint64_t y = 0; y < view->height; y++)
+                {
+                        strip->rows++;
+                        strip->cost += row_cost[y / step];
+                        if ((strip->cost >= target || strip->rows == max_rows) && y + 1 < view->height &&
+                            strip_count + 2 < capacity)
+                        {
+                                strip = &(*strips)[++strip_count];
+                                strip->y = y + 1;
+                        }
+                }
+                strip_count++;
+        }
+        free(row_cost);
+        free(counts);
+        render_plan_destroy(plan);
+        threadpool_destroy(pool);
+        return strip_count;
+}
+
+// open_outputs: Erstellt für jedes Farbschema eine Datei wie bei einzelnen Bildern.
+// Gibt 0 zurück, falls eine Datei nicht erstellt werden konnte
+static _Bool open_outputs(struct coordinator *coordinator, const char *file_name, const render_options *options,
+                          uint64_t width, uint64_t height, int16_t max_iterations)
+{
+        const char *extension = image_format_extension(coordinator->format);
+        char path[strlen(file_name) + 32];
+        for (unsigned p = 0; p < options->palette_count; p++)
+        {
+                if (p == 0)
+                        snprintf(path, sizeof(path), "%s%s", file_name, extension);
+                else
+                        snprintf(path, sizeof(path), "%s_%s%s", file_name, palette_name(options->palettes[p]), extension);
+                coordinator->palettes[p] = palette_create(options->palettes[p], max_iterations,
+                                                          image_format_rgb(coordinator->format));
+                coordinator->file_count = p + 1;
+                if (coordinator->palettes[p] == NULL)
+                {
+                        fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                        fflush(stderr);
+                        return 0;
+                }
+                image_writer_settings settings = {
+                    .rows_per_strip = options->strip_height == 0 || options->strip_height > height ? height
+                                                                                                  : options->strip_height,
+                };
+                settings.colors = palette_colors(coordinator->palettes[p], &settings.color_count);
+                coordinator->writers[p] = image_writer_open(path, coordinator->format, width, height, &settings);
+                if (coordinator->writers[p] == NULL)
+                {
+                        fprintf(stderr, "   Die Datei %s konnte nicht erstellt werden.\r\n", path);
+                        fflush(stderr);
+                        return 0;
+                }
+        }
+        return 1;
+}
+
+// close_outputs: Schließt alle Dateien. Gibt 0 zurück, falls eine nicht vollständig
+// geschrieben werden konnte
+static _Bool close_outputs(struct coordinator *coordinator)
+{
+        _Bool closed = 1;
+        for (unsigned p = 0; p < coordinator->file_count; p++)
+        {
+                if (coordinator->writers[p] != NULL && !image_writer_close(coordinator->writers[p]))
+                        closed = 0;
+                palette_destroy(coordinator->palettes[p]);
+        }
+        return closed;
+}
+
+// parse_workers: Zerlegt die Liste host:port,host:port in die Verbindungen. Gibt die
+// Anzahl der Worker oder 0 bei einem ungültigen Eintrag zurück
+static unsigned parse_workers(char *list, struct remote *remotes, unsigned capacity)
+{
+        unsigned count = 0;
+        char *state;
+        for (char *entry = strtok_r(list, ",", &state); entry != NULL; entry = strtok_r(NULL, ",", &state))
+        {
+                char *colon = strrchr(entry, ':');
+                if (count == capacity || colon == NULL || colon == entry || colon[1] == '\0')
+                        return 0;
+                *colon = '\0';
+                remotes[count].host = entry;
+                remotes[count].port = colon + 1;
+                remotes[count].fd = -1;
+                count++;
+        }
+        return count;
+}
+
+int distribute(const char *file_name, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+               double resolution, int16_t max_iterations, const render_options *options,
+               const distribute_settings *settings)
+{
+        // Eingaben wie bei einzelnen Bildern prüfen
+        const char *error = NULL;
+        if (resolution <= 0)
+                error = "Die Resolution darf nicht negativ oder 0 sein.";
+        else if (max_iterations < 0)
+                error = "Die Anzahl der maximalen Iterationen darf nicht kleiner 0 sein.";
+        else if (r_start < -2 || r_start > 1 || r_end < -2 || r_end > 1)
+                error = "Die Eingaben für r_start und r_end müssen im Interval [-2;1] liegen.";
+        else if (i_start < -1 || i_start > 1 || i_end < -1 || i_end > 1)
+                error = "Die Eingaben für i_start und i_end müssen im Interval [-1;1] liegen.";
+        precision_tier precision = precision_resolve(options->precision, r_start, r_end, i_start, i_end, resolution);
+        uint64_t width = error == NULL ? render_dimension(r_start, r_end, resolution, precision) : 0;
+        uint64_t height = error == NULL ? render_dimension(i_start, i_end, resolution, precision) : 0;
+        if (error == NULL && (width == 0 || height == 0 || width > RENDER_MAX_IMAGE_SIZE / 3 / height))
+                error = "Mit den eingegebenen Parametern kann keine Berechnung durchgeführt werden.";
+
+        // Nur abgebildete Formate lassen sich in beliebiger Reihenfolge füllen
+        image_format format = image_format_resolve(options->format, width, height);
+        if (error == NULL && format == IMAGE_FORMAT_AUTO)
+                error = "Das Bild ist für das gewählte Dateiformat zu groß.";
+        else if (error == NULL && (format == IMAGE_FORMAT_RLE8 || format == IMAGE_FORMAT_PNG))
+                error = "Verteilt sind nur die Formate bmp, bmp8 und bigtiff möglich.";
+        kernel_variant kernel = kernel_resolve(options->kernel);
+        if (error == NULL && !kernel_supported(kernel))
+                error = "Der Kernel des Koordinators wird von diesem Prozessor nicht unterstützt.";
+
+        size_t list_length = settings->workers != NULL ? strlen(settings->workers) : 0;
+        char list[list_length + 1];
+        struct remote remotes[list_length / 2 + 1];
+        memset(remotes, 0, sizeof(remotes));
+        memcpy(list, settings->workers != NULL ? settings->workers : "", list_length + 1);
+        unsigned remote_count = parse_workers(list, remotes, list_length / 2 + 1);
+        if (error == NULL && remote_count == 0)
+                error = "Die Worker müssen mit --workers=host:port,host:port angegeben werden.";
+        if (error != NULL)
+        {
+                fprintf(stderr, "   %s\r\n", error);
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        render_view view = {
+            .r_start = r_start,
+            .i_start = i_start,
+            .resolution = resolution,
+            .max_iterations = max_iterations,
+            .width = width,
+            .height = height,
+        };
+        struct coordinator coordinator = {
+            .request = {
+                .magic = REQUEST_MAGIC,
+                .precision = (uint32_t)precision,
+                .max_iterations = max_iterations,
+                .r_start = r_start,
+                .i_start = i_start,
+                .resolution = resolution,
+                .width = width,
+                .height = height,
+            },
+            .timeout = settings->timeout > 0 ? settings->timeout : 1,
+            .format = format,
+            .alive = remote_count,
+        };
+        double start = curtime();
+        coordinator.strip_count = split_strips(&view, options, kernel, precision, (uint64_t)remote_count * STRIPS_PER_WORKER,
+                                               &coordinator.strips);
+        if (coordinator.strip_count == 0)
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+                free(coordinator.strips);
+                return EXIT_FAILURE;
+        }
+        if (!open_outputs(&coordinator, file_name, options, width, height, max_iterations))
+        {
+                close_outputs(&coordinator);
+                free(coordinator.strips);
+                return EXIT_FAILURE;
+        }
+        printf("   Verteile %" PRIu64 "x%" PRIu64 " Pixel in %" PRIu64 " Streifen auf %u Worker (Genauigkeit %s).\r\n",
+               width, height, coordinator.strip_count, remote_count, precision_name(precision));
+        fflush(stdout);
+
+        pthread_mutex_init(&coordinator.lock, NULL);
+        pthread_cond_init(&coordinator.changed, NULL);
+        for (unsigned r = 0; r < remote_count; r++)
+        {
+                remotes[r].coordinator = &coordinator;
+                remotes[r].started = !pthread_create(&remotes[r].thread, NULL, remote_main, &remotes[r]);
+                if (!remotes[r].started)
+                {
+                        pthread_mutex_lock(&coordinator.lock);
+                        coordinator.alive--;
+                        pthread_mutex_unlock(&coordinator.lock);
+                }
+        }
+
+        // Warten, bis alle Streifen fertig oder alle Worker ausgefallen sind. Danach
+        // beendet das Trennen der Verbindungen noch laufende zweite Berechnungen
+        pthread_mutex_lock(&coordinator.lock);
+        while (coordinator.done < coordinator.strip_count && coordinator.alive > 0 && !coordinator.failed)
+                pthread_cond_wait(&coordinator.changed, &coordinator.lock);
+        coordinator.finished = 1;
+        for (unsigned r = 0; r < remote_count; r++)
+        {
+                if (remotes[r].fd >= 0)
+                        shutdown(remotes[r].fd, SHUT_RDWR);
+        }
+        pthread_cond_broadcast(&coordinator.changed);
+        pthread_mutex_unlock(&coordinator.lock);
+        for (unsigned r = 0; r < remote_count; r++)
+        {
+                if (remotes[r].started)
+                        pthread_join(remotes[r].thread, NULL);
+                free(remotes[r].counts);
+                free(remotes[r].data);
+        }
+        pthread_mutex_destroy(&coordinator.lock);
+        pthread_cond_destroy(&coordinator.changed);
+        double time = curtime() - start;
+
+        for (unsigned r = 0; r < remote_count; r++)
+                printf("   Worker %s:%s: %" PRIu64 " Streifen in %f Sekunden%s.\r\n", remotes[r].host, remotes[r].port,
+                       remotes[r].strips, remotes[r].busy, remotes[r].dead ? ", ausgefallen" : "");
+        fflush(stdout);
+        _Bool complete = coordinator.done == coordinator.strip_count;
+        _Bool closed = close_outputs(&coordinator) && !coordinator.failed;
+        free(coordinator.strips);
+        if (!complete && !coordinator.failed)
+        {
+                fprintf(stderr, "   Alle Worker sind ausgefallen, %" PRIu64 " von %" PRIu64 " Streifen fehlen.\r\n",
+                        coordinator.strip_count - coordinator.done, coordinator.strip_count);
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+        if (!complete || !closed)
+        {
+                fprintf(stderr, "   Die Datei %s%s konnte nicht geschrieben werden.\r\n", file_name, image_format_extension(format));
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+        printf("   Die Berechnung hat %f Sekunden gedauert (%" PRIu64 " Streifen erneut vergeben, %" PRIu64 " doppelt berechnet).\r\n",
+               time, coordinator.requeued, coordinator.backups);
+        printf("   Bild \"%s%s\" wurde erfolgreich erzeugt.\r\n", file_name, image_format_extension(format));
+        fflush(stdout);
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+// Include Guards
+#ifndef DISTRIBUTE_H
+#define DISTRIBUTE_H
+#include "render.h"
+
+// Einstellungen des verteilten Modus
+typedef struct
+{
+        const char *listen;  // worker: Adresse, auf der Verbindungen angenommen werden
+        unsigned port;       // worker: TCP Port
+        const char *workers; // Koordinator: kommagetrennte Liste host:port der Worker
+        unsigned timeout;    // Koordinator: Sekunden ohne Antwort, bis ein Worker als ausgefallen gilt
+} distribute_settings;
+
+// distribute_worker: Nimmt auf listen:port nacheinander Verbindungen von Koordinatoren
+// an und berechnet die angefragten Streifen mit allen Threads von options. Kernel,
+// Kachelgröße und Modus bestimmt der Worker, Ausschnitt und Genauigkeit der
+// Koordinator. Läuft bis zum Abbruch des Prozesses. Gibt EXIT_FAILURE zurück, falls
+// der Port nicht geöffnet werden kann
+int distribute_worker(const render_options *options, const distribute_settings *settings);
+
+// distribute: Berechnet ein Bild auf den Workern der Einstellungen. Der Koordinator
+// schätzt die Kosten jeder Zeile an einem groben Raster und teilt das Bild in Streifen
+// etwa gleicher Kosten, mehrere je Worker. Jeder Worker holt sich über eine eigene
+// Verbindung den nächsten offenen Streifen. Streifen eines ausgefallenen oder zu
+// langsamen Workers werden erneut vergeben, das erste Ergebnis gilt. Die
+// Iterationszähler werden eingefärbt und direkt an ihre Stelle in den abgebildeten
+// Dateien (bmp, bmp8, bigtiff) geschrieben. Gibt EXIT_SUCCESS oder EXIT_FAILURE zurück
+int distribute(const char *file_name, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+               double resolution, int16_t max_iterations, const render_options *options,
+               const distribute_settings *settings);
+
+#endif // !DISTRIBUTE_H
@@ -0,0 +1,146 @@
+#include <string.h>
+#include "kernel.h"
+
+// Namen der Varianten in der Reihenfolge von kernel_variant
+static const char *const kernel_names[] = {"auto", "c", "sse", "avx2", "avx512"};
+
+// Namen der Zuordnungen in der Reihenfolge von lane_mode
+static const char *const lane_mode_names[] = {"group", "refill", "unroll"};
+
+_Bool kernel_parse(const char *name, kernel_variant *variant)
+{
+        for (unsigned i = 0; i < sizeof(kernel_names) / sizeof(*kernel_names); i++)
+        {
+                if (!strcmp(name, kernel_names[i]))
+                {
+                        *variant = (kernel_variant)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+const char *kernel_name(kernel_variant variant)
+{
+        return kernel_names[variant];
+}
+
+_Bool lane_mode_parse(const char *name, lane_mode *lanes)
+{
+        for (unsigned i = 0; i < sizeof(lane_mode_names) / sizeof(*lane_mode_names); i++)
+        {
+                if (!strcmp(name, lane_mode_names[i]))
+                {
+                        *lanes = (lane_mode)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+const char *lane_mode_name(lane_mode lanes)
+{
+        return lane_mode_names[lanes];
+}
+
+// __builtin_cpu_supports wertet CPUID aus und berücksichtigt über XGETBV auch,
+// ob das Betriebssystem die breiten Register beim Kontextwechsel sichert. Die
+// AVX-512 Kernel verwenden nur Befehle aus AVX-512F, nicht aus DQ, BW oder VL
+_Bool kernel_supported(kernel_variant variant)
+{
+        __builtin_cpu_init();
+        switch (variant)
+        {
+        case KERNEL_AVX512:
+                return __builtin_cpu_supports("avx512f");
+        case KERNEL_AVX2:
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case KERNEL_SSE:
+                return __builtin_cpu_supports("sse4.1");
+        default:
+                return 1;
+        }
+}
+
+kernel_variant kernel_resolve(kernel_variant variant)
+{
+        if (variant != KERNEL_AUTO)
+                return variant;
+        if (kernel_supported(KERNEL_AVX512))
+                return KERNEL_AVX512;
+        if (kernel_supported(KERNEL_AVX2))
+                return KERNEL_AVX2;
+        if (kernel_supported(KERNEL_SSE))
+                return KERNEL_SSE;
+        return KERNEL_C;
+}
+
+// unroll_index: Wählt die Blocklänge der verschränkten Kernel (0: 1, 1: 4, 2: 8
+// Iterationen). Jeder Block, in dem ein Element die Grenze überschreitet, wird
+// einzeln wiederholt. Bei wenigen Iterationen passiert das so oft, dass nur die
+// Verschränkung ohne Blöcke lohnt, bei vielen Iterationen sparen lange Blöcke die
+// meisten Prüfungen. Die Schwellen sind mit bench gemessen
+static unsigned unroll_index(int16_t max_iterations)
+{
+        if (max_iterations < 1024)
+                return 0;
+        if (max_iterations < 8192)
+                return 1;
+        return 2;
+}
+
+tile_kernel kernel_get(kernel_variant variant, lane_mode lanes, int16_t max_iterations)
+{
+        static const tile_kernel unroll[] = {mandelbrot_tile_unroll1_avx512, mandelbrot_tile_unroll4_avx512,
+                                             mandelbrot_tile_unroll8_avx512};
+        switch (kernel_resolve(variant))
+        {
+        case KERNEL_AVX512:
+                if (lanes == LANES_UNROLL)
+                        return unroll[unroll_index(max_iterations)];
+                return lanes == LANES_REFILL ? mandelbrot_tile_refill_avx512 : mandelbrot_tile_avx512;
+        case KERNEL_AVX2:
+                return mandelbrot_tile_avx2;
+        case KERNEL_SSE:
+                return mandelbrot_tile;
+        default:
+                return mandelbrot_c_tile;
+        }
+}
+
+tile_kernel_double kernel_get_double(kernel_variant variant, lane_mode lanes, int16_t max_iterations)
+{
+        static const tile_kernel_double unroll[] = {mandelbrot_tile_double_unroll1_avx512,
+                                                    mandelbrot_tile_double_unroll4_avx512,
+                                                    mandelbrot_tile_double_unroll8_avx512};
+        switch (kernel_resolve(variant))
+        {
+        case KERNEL_AVX512:
+                if (lanes == LANES_UNROLL)
+                        return unroll[unroll_index(max_iterations)];
+                return lanes == LANES_REFILL ? mandelbrot_tile_double_refill_avx512 : mandelbrot_tile_double_avx512;
+        case KERNEL_AVX2:
+                return mandelbrot_tile_double_avx2;
+        default:
+                return mandelbrot_c_tile_double;
+        }
+}
+
+_Bool kernel_uses_fma(kernel_variant variant)
+{
+        kernel_variant resolved = kernel_resolve(variant);
+        return resolved == KERNEL_AVX2 || resolved == KERNEL_AVX512;
+}
+
+unsigned kernel_lanes(kernel_variant variant, _Bool double_precision)
+{
+        switch (kernel_resolve(variant))
+        {
+        case KERNEL_AVX512:
+                return double_precision ? 8 : 16;
+        case KERNEL_AVX2:
+                return double_precision ? 4 : 8;
+        default:
+                return 4;
+        }
+}
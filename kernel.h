@@ -0,0 +1,68 @@
+// Include Guards
+#ifndef KERNEL_H
+#define KERNEL_H
+#include "mandelbrot.h"
+
+// Verfügbare Varianten der Kachel-Kernel. KERNEL_AUTO wählt zur Laufzeit die
+// schnellste vom Prozessor unterstützte Variante
+typedef enum
+{
+        KERNEL_AUTO,
+        KERNEL_C,
+        KERNEL_SSE,
+        KERNEL_AVX2,
+        KERNEL_AVX512,
+} kernel_variant;
+
+// Zuordnung von Pixeln zu Vektorelementen. LANES_GROUP berechnet feste Gruppen
+// benachbarter Pixel, bis das langsamste Element fertig ist. Bei LANES_REFILL lädt
+// jedes fertige Element sofort das nächste Pixel der Kachel nach. LANES_UNROLL
+// rechnet zwei Gruppen verschränkt und prüft die Abbruchbedingung nur nach Blöcken
+// mehrerer Iterationen, deren Länge sich nach i_max richtet
+typedef enum
+{
+        LANES_GROUP,
+        LANES_REFILL,
+        LANES_UNROLL,
+} lane_mode;
+
+// kernel_parse: Übersetzt den Namen einer Variante ("auto", "c", "sse", "avx2",
+// "avx512"). Gibt 0 zurück, falls der Name unbekannt ist
+_Bool kernel_parse(const char *name, kernel_variant *variant);
+
+// kernel_name: Gibt den Namen einer Variante zurück
+const char *kernel_name(kernel_variant variant);
+
+// kernel_supported: Prüft per CPUID, ob der Prozessor die Variante ausführen kann
+_Bool kernel_supported(kernel_variant variant);
+
+// kernel_resolve: Ersetzt KERNEL_AUTO durch die schnellste unterstützte Variante
+kernel_variant kernel_resolve(kernel_variant variant);
+
+// lane_mode_parse: Übersetzt den Namen einer Zuordnung ("group", "refill", "unroll"). Gibt 0
+// zurück, falls der Name unbekannt ist
+_Bool lane_mode_parse(const char *name, lane_mode *lanes);
+
+// lane_mode_name: Gibt den Namen einer Zuordnung zurück
+const char *lane_mode_name(lane_mode lanes);
+
+// kernel_get: Gibt die Kachelfunktion einer Variante für Bilder mit max_iterations
+// Iterationen zurück. Nachladende und verschränkte Kernel existieren nur für
+// AVX-512, alle anderen Varianten rechnen in Gruppen
+tile_kernel kernel_get(kernel_variant variant, lane_mode lanes, int16_t max_iterations);
+
+// kernel_get_double: Gibt die Kachelfunktion mit doppelter Genauigkeit einer
+// Variante zurück. Für SSE existiert keine eigene Variante, hier wird die
+// Referenzimplementierung verwendet
+tile_kernel_double kernel_get_double(kernel_variant variant, lane_mode lanes, int16_t max_iterations);
+
+// kernel_uses_fma: Prüft, ob die Variante Multiplikation und Addition in FMA Befehlen
+// zusammenfasst. Ihre Zähler weichen an Rändern leicht von denen der übrigen ab
+_Bool kernel_uses_fma(kernel_variant variant);
+
+// kernel_lanes: Anzahl der Pixel, die eine Variante gleichzeitig berechnet. Kacheln,
+// deren Breite ein Vielfaches davon ist, nutzen alle Vektorelemente. Die skalaren
+// Varianten geben die minimale Kachelbreite 4 zurück
+unsigned kernel_lanes(kernel_variant variant, _Bool double_precision);
+
+#endif // !KERNEL_H
@@ -1,20 +1,23 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
-#include <time.h>
 #include <unistd.h>
-#include "bmp.h"
-
-// Methodendeklaration der Assembly Implementierung des Algorithmus (mandelbrot.S)
-extern void mandelbrot(float r_start, float r_end, float i_start, float i_end, float resolution, unsigned char *img, int16_t max_iterations);
-
-// Methodendeklaration der Referenzimplementierung des zu entwickelnden Algorithmus
-void mandelbrot_c(float r_start, float r_end, float i_start, float i_end, float resolution, unsigned char *img, int16_t max_iterations);
+#include "animate.h"
+#include "batch.h"
+#include "bench.h"
+#include "context.h"
+#include "distribute.h"
+#include "mandelbrot.h"
+#include "server.h"
+#include "threadpool.h"
+#include "timer.h"
 
 // Methodendeklaration der Methode zur Validierung der Eingaben, Ausführen des Algorithmus und
 // Verifikation der Korrektheit des Ergebnisses
-int calculate_mandelbrot(char *file_name, float r_start, float r_end, float i_start, float i_end, float resolution, int16_t max_iterations);
+int calculate_mandelbrot(char *file_name, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end, double resolution,
+                         int16_t max_iterations, const render_options *options);
 
 // Methodendeklaration der Methode zum automatisierten Testen von Eingaben
 int test();
@@ -23,21 +26,343 @@ int test();
 _Bool test_input(int index, char *input, char *expected, float r_start, float r_end,
                  float i_start, float i_end, float resolution, int16_t max_iterations);
 
-// Methodendeklaration der statischen Methode zur Rückgabe der aktuellen Zeit
-static double curtime(void);
+// Methodendeklaration der Methode zum Vergleich von Animationen mit und ohne Übernahme von Kacheln
+_Bool test_reuse(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                 double resolution, int16_t max_iterations, const animation_settings *settings, _Bool pan);
+
+// Methodendeklaration der Methode zum Vergleich von Bildern mit und ohne Spiegelung
+_Bool test_mirror(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                  double resolution, int16_t max_iterations, kernel_variant kernel, precision_tier precision);
+
+// Methodendeklaration der Methode zur Prüfung, ob gespiegelt bzw. der Grund dafür gemeldet wird
+_Bool test_mirror_reason(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                         double resolution, int16_t max_iterations, _Bool mirrored);
+
+// Methodendeklaration der Methode zur Prüfung der Zeiten des Stats-Modus
+_Bool test_stats(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                 double resolution, int16_t max_iterations);
+
+// Methodendeklaration der Methode zum vollständigen Vergleich mit der Referenzimplementierung
+_Bool test_verify(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                  double resolution, int16_t max_iterations, kernel_variant kernel, precision_tier precision,
+                  render_mode mode);
+
+// Methodendeklaration der Methode zum byteweisen Vergleich zweier Dateien
+static _Bool files_equal(const char *first, const char *second);
+
+// Methodendeklaration der Methode zum Auslesen von Optionen der Form "--name=wert"
+// oder "--name wert"
+static char *option_value(int argc, char *argv[], int *index, const char *name);
 
 // Main Methode: Nimmt Startparameter entgegen und ruft die Berechnungs- oder Testmethode auf
 int main(int argc, char *argv[])
 {
 
         // Initialisierung der Standardwerte zur Berechnung
-        char *file_name = "mandelbrot.bmp";
-        float r_start = -2;
-        float r_end = 1;
-        float i_start = -1;
-        float i_end = 1;
-        float resolution = 0.001;
+        char *file_name = "mandelbrot";
+        hp_float r_start = -2;
+        hp_float r_end = 1;
+        hp_float i_start = -1;
+        hp_float i_end = 1;
+        double resolution = 0.001;
         int16_t max_iterations = 255;
+        render_options options = {
+            .threads = threadpool_default_threads(),
+            .tile_size = 64,
+            .kernel = KERNEL_AUTO,
+            .precision = PRECISION_AUTO,
+            .strip_height = 256,
+            .format = IMAGE_FORMAT_AUTO,
+            .mode = RENDER_MODE_SCAN,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_SAMPLED,
+            .sample_rate = 0.01,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+            .cache_path = NULL,
+            .cache_size = 256ULL << 20,
+        };
+        bench_settings bench_options = {
+            .repetitions = 10,
+            .warmup = 2,
+            .output = "bench.csv",
+        };
+        server_settings server_options = {
+            .port = 8080,
+            .connections = 4,
+            .memory_size = 64ULL << 20,
+            .max_iterations = 255,
+        };
+        animation_settings animation_options = {
+            .frames = 60,
+            .reuse = 1,
+        };
+        batch_settings batch_options = {
+            .input = NULL,
+            .jobs = 0,
+        };
+        distribute_settings distribute_options = {
+            .listen = "127.0.0.1",
+            .port = 9000,
+            .workers = NULL,
+            .timeout = 60,
+        };
+
+        // Optionen werden vor der Auswertung der Positionsparameter aus den
+        // Startparametern entfernt. Negative Zahlen beginnen nur mit einem
+        // Bindestrich und werden daher nicht als Option interpretiert
+        char *value;
+        int positional_count = 1;
+        for (int i = 1; i < argc; i++)
+        {
+                if ((value = option_value(argc, argv, &i, "threads")) != NULL)
+                {
+                        options.threads = atoi(value) > 0 ? (unsigned)atoi(value) : 1;
+                }
+                else if ((value = option_value(argc, argv, &i, "tile")) != NULL)
+                {
+                        // Kacheln müssen wie das Bild eine durch 4 teilbare Breite haben
+                        long tile_size = atol(value);
+                        options.tile_size = tile_size < 4 ? 4 : (uint64_t)(tile_size - tile_size % 4);
+                }
+                else if ((value = option_value(argc, argv, &i, "kernel")) != NULL)
+                {
+                        if (!kernel_parse(value, &options.kernel))
+                        {
+                                fprintf(stderr, "Unbekannter Kernel '%s'. Möglich sind auto, c, sse, avx2 und avx512.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "precision")) != NULL)
+                {
+                        if (!precision_parse(value, &options.precision))
+                        {
+                                fprintf(stderr, "Unbekannte Genauigkeit '%s'. Möglich sind auto, float, double und perturbation.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "strip")) != NULL)
+                {
+                        options.strip_height = atol(value) > 0 ? (uint64_t)atol(value) : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "format")) != NULL)
+                {
+                        if (!image_format_parse(value, &options.format))
+                        {
+                                fprintf(stderr, "Unbekanntes Format '%s'. Möglich sind auto, bmp, bigtiff, bmp8, rle8 und png.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "mode")) != NULL)
+                {
+                        if (!render_mode_parse(value, &options.mode))
+                        {
+                                fprintf(stderr, "Unbekannter Modus '%s'. Möglich sind scan und subdivide.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "lanes")) != NULL)
+                {
+                        if (!lane_mode_parse(value, &options.lanes))
+                        {
+                                fprintf(stderr, "Unbekannte Zuordnung '%s'. Möglich sind group, refill und unroll.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "verify")) != NULL)
+                {
+                        if (!verify_mode_parse(value, &options.verify))
+                        {
+                                fprintf(stderr, "Unbekannte Überprüfung '%s'. Möglich sind off, full und sampled.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "sample")) != NULL)
+                {
+                        // Angabe in Prozent der Zeilen
+                        double percent = atof(value);
+                        options.sample_rate = percent > 100 ? 1 : percent > 0 ? percent / 100 : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "palette")) != NULL)
+                {
+                        // Kommagetrennte Liste, jedes Schema höchstens einmal
+                        options.palette_count = 0;
+                        for (char *name = strtok(value, ","); name != NULL; name = strtok(NULL, ","))
+                        {
+                                palette_scheme scheme;
+                                if (!palette_parse(name, &scheme) || options.palette_count == PALETTE_COUNT)
+                                {
+                                        fprintf(stderr, "Unbekanntes Farbschema '%s'. Möglich sind classic und gray.\r\n", name);
+                                        fflush(stderr);
+                                        exit(EXIT_FAILURE);
+                                }
+                                options.palettes[options.palette_count++] = scheme;
+                        }
+                        if (options.palette_count == 0)
+                        {
+                                options.palettes[0] = PALETTE_CLASSIC;
+                                options.palette_count = 1;
+                        }
+                }
+                else if ((value = option_value(argc, argv, &i, "cache")) != NULL)
+                {
+                        options.cache_path = *value != '\0' ? value : NULL;
+                }
+                else if ((value = option_value(argc, argv, &i, "cache-size")) != NULL)
+                {
+                        // Angabe in MiB
+                        options.cache_size = atoll(value) > 0 ? (uint64_t)atoll(value) << 20 : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "progressive")) != NULL)
+                {
+                        if (strcmp(value, "on") && strcmp(value, "off"))
+                        {
+                                fprintf(stderr, "Unbekannte Einstellung '%s' für --progressive. Möglich sind on und off.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                        options.progressive = !strcmp(value, "on");
+                }
+                else if ((value = option_value(argc, argv, &i, "mirror")) != NULL)
+                {
+                        if (strcmp(value, "on") && strcmp(value, "off"))
+                        {
+                                fprintf(stderr, "Unbekannte Einstellung '%s' für --mirror. Möglich sind on und off.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                        options.mirror = !strcmp(value, "on");
+                }
+                else if ((value = option_value(argc, argv, &i, "antialias")) != NULL)
+                {
+                        options.antialias = atoi(value) > 0 ? (unsigned)atoi(value) : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "stats")) != NULL)
+                {
+                        options.stats_path = value;
+                }
+                else if ((value = option_value(argc, argv, &i, "jobs")) != NULL)
+                {
+                        batch_options.jobs = atoi(value) > 0 ? (unsigned)atoi(value) : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "to")) != NULL)
+                {
+                        // Endausschnitt der Animation als "r_start,r_end,i_start,i_end"
+                        hp_float bounds[4];
+                        unsigned count = 0;
+                        for (char *bound = strtok(value, ","); bound != NULL && count < 4; bound = strtok(NULL, ","))
+                                bounds[count++] = hp_parse(bound);
+                        if (count != 4)
+                        {
+                                fprintf(stderr, "Der Endausschnitt muss als r_start,r_end,i_start,i_end angegeben werden.\r\n");
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                        animation_options.r_start = bounds[0];
+                        animation_options.r_end = bounds[1];
+                        animation_options.i_start = bounds[2];
+                        animation_options.i_end = bounds[3];
+                        animation_options.has_end = 1;
+                }
+                else if ((value = option_value(argc, argv, &i, "frames")) != NULL)
+                {
+                        animation_options.frames = atoll(value) > 0 ? (uint64_t)atoll(value) : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "reuse")) != NULL)
+                {
+                        if (strcmp(value, "on") && strcmp(value, "off") && strcmp(value, "fill"))
+                        {
+                                fprintf(stderr, "Unbekannte Einstellung '%s' für --reuse. Möglich sind on, off und fill.\r\n", value);
+                                fflush(stderr);
+                                exit(EXIT_FAILURE);
+                        }
+                        animation_options.reuse = strcmp(value, "off") != 0;
+                        animation_options.fill = !strcmp(value, "fill");
+                }
+                else if ((value = option_value(argc, argv, &i, "repeat")) != NULL)
+                {
+                        bench_options.repetitions = atoi(value) > 0 ? (unsigned)atoi(value) : 1;
+                }
+                else if ((value = option_value(argc, argv, &i, "warmup")) != NULL)
+                {
+                        bench_options.warmup = atoi(value) > 0 ? (unsigned)atoi(value) : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "output")) != NULL)
+                {
+                        bench_options.output = value;
+                }
+                else if ((value = option_value(argc, argv, &i, "port")) != NULL)
+                {
+                        server_options.port = atoi(value) > 0 ? (unsigned)atoi(value) : 0;
+                        distribute_options.port = server_options.port;
+                }
+                else if ((value = option_value(argc, argv, &i, "listen")) != NULL)
+                {
+                        distribute_options.listen = value;
+                }
+                else if ((value = option_value(argc, argv, &i, "workers")) != NULL)
+                {
+                        distribute_options.workers = value;
+                }
+                else if ((value = option_value(argc, argv, &i, "timeout")) != NULL)
+                {
+                        distribute_options.timeout = atoi(value) > 0 ? (unsigned)atoi(value) : 1;
+                }
+                else if ((value = option_value(argc, argv, &i, "connections")) != NULL)
+                {
+                        server_options.connections = atoi(value) > 0 ? (unsigned)atoi(value) : 1;
+                }
+                else if ((value = option_value(argc, argv, &i, "memory")) != NULL)
+                {
+                        // Angabe in MiB
+                        server_options.memory_size = atoll(value) > 0 ? (uint64_t)atoll(value) << 20 : 0;
+                }
+                else if ((value = option_value(argc, argv, &i, "imax")) != NULL)
+                {
+                        server_options.max_iterations = (int16_t)atoi(value);
+                }
+                else if (!strncmp(argv[i], "--", 2) && strcmp(argv[i], "--help") && strcmp(argv[i], "--hilfe"))
+                {
+                        fprintf(stderr, "Unbekannte Option '%s'\r\n", argv[i]);
+                        fflush(stderr);
+                        exit(EXIT_FAILURE);
+                }
+                else
+                {
+                        argv[positional_count++] = argv[i];
+                }
+        }
+        argc = positional_count;
+
+        // Batch: "batch" gefolgt von der optionalen Datei der Aufträge (sonst stdin)
+        if (argc > 1 && !strcmp(argv[1], "batch"))
+        {
+                if (argc > 3)
+                {
+                        fprintf(stderr, "Bitte halten sie sich an das Format 'batch [auftragsdatei]'\r\n");
+                        fflush(stderr);
+                        exit(EXIT_FAILURE);
+                }
+                batch_options.input = argc == 3 ? argv[2] : NULL;
+                exit(batch(&options, &batch_options));
+        }
+
+        // Animation: "animate" gefolgt vom Startausschnitt im gewohnten Format. Der
+        // erste Parameter wird entfernt, der Rest wie bei einem einzelnen Bild ausgewertet
+        _Bool animation = argc > 1 && !strcmp(argv[1], "animate");
+        _Bool distributed = argc > 1 && !strcmp(argv[1], "distribute");
+        if (animation || distributed)
+        {
+                argv[1] = argv[0];
+                argv++;
+                argc--;
+        }
 
         // Falls Startparameter vorhanden, werden Standardwerte überschrieben
         switch (argc)
@@ -48,16 +373,65 @@ int main(int argc, char *argv[])
 
         // Falls die automatischen Tests ausgeführt werden sollen
         case 2:
-                if (!strcmp(argv[1], "test"))
+                if (animation || distributed)
+                        break;
+                else if (!strcmp(argv[1], "test"))
                 {
                         printf("Tests starten...\r\n");
                         exit(test());
                 }
+                else if (!strcmp(argv[1], "bench"))
+                {
+                        printf("Benchmark starten...\r\n");
+                        exit(bench(&options, &bench_options));
+                }
+                else if (!strcmp(argv[1], "serve"))
+                {
+                        exit(serve(&options, &server_options));
+                }
+                else if (!strcmp(argv[1], "worker"))
+                {
+                        exit(distribute_worker(&options, &distribute_options));
+                }
                 else if (!strcmp(argv[1], "-h") ||
                          !strcmp(argv[1], "--help") ||
                          !strcmp(argv[1], "--hilfe"))
                 {
                         printf("Format:\n[dateiname], r_start, r_end, i_start, i_end, resolution, i_max\n");
+                        printf("Oder: test, bench, serve, worker, batch [auftragsdatei], animate bzw. distribute [dateiname] r_start r_end i_start i_end resolution i_max\n");
+                        printf("Optionen:\n");
+                        printf("  --threads=N  Anzahl der Threads (Standard: Anzahl der Prozessorkerne)\n");
+                        printf("  --tile=N     Kantenlänge der parallel berechneten Kacheln (Standard: 64)\n");
+                        printf("  --kernel=K   Kernel erzwingen: auto, c, sse, avx2, avx512 (Standard: auto)\n");
+                        printf("  --precision=P  Genauigkeit: auto, float, double, perturbation (Standard: auto)\n");
+                        printf("  --strip=N    Zeilen pro geschriebenem Streifen, 0 für das ganze Bild (Standard: 256)\n");
+                        printf("  --format=F   Dateiformat: auto, bmp, bigtiff, bmp8, rle8, png (Standard: auto)\n");
+                        printf("  --mode=M     Berechnung der Kacheln: scan, subdivide (Standard: scan)\n");
+                        printf("  --lanes=L    Vektorelemente: group, refill, unroll (Standard: unroll)\n");
+                        printf("  --verify=V   Vergleich mit der C Referenz: off, full, sampled (Standard: sampled)\n");
+                        printf("  --palette=P  Farbschemata, kommagetrennt, je eine Datei: classic, gray (Standard: classic)\n");
+                        printf("  --sample=P   Geprüfte Zeilen in Prozent bei sampled (Standard: 1)\n");
+                        printf("  --cache=F    Datei des Kachel-Caches für wiederholte Ausschnitte (Standard: kein Cache)\n");
+                        printf("  --cache-size=N  Maximale Größe des Kachel-Caches in MiB (Standard: 256)\n");
+                        printf("  --progressive=on  Vorschau in %d Durchläufen von grob bis fein schreiben: on, off (Standard: off)\n", RENDER_PASSES);
+                        printf("  --mirror=on  Zeilenpaare beiderseits der reellen Achse nur einmal berechnen: on, off (Standard: off)\n");
+                        printf("  --antialias=N  Randpixel mit N x N Stichproben glätten, nur bmp und bigtiff (Standard: 1, aus)\n");
+                        printf("  --stats=F    Iterationen, Auslastung der Vektoren und Zeiten ausgeben, Kernelzeit je Kachel als CSV Datei F\n");
+                        printf("  --to=R       animate: Endausschnitt als r_start,r_end,i_start,i_end\n");
+                        printf("  --frames=N   animate: Anzahl der Bilder (Standard: 60)\n");
+                        printf("  --reuse=on   animate: Kacheln aus dem vorherigen Bild übernehmen: on, off, fill (Standard: on)\n");
+                        printf("  --port=N     serve: TCP Port auf 127.0.0.1 (Standard: 8080)\n");
+                        printf("  --connections=N  serve: gleichzeitig bearbeitete Verbindungen (Standard: 4)\n");
+                        printf("  --memory=N   serve: Größe der kodierten Kacheln im Speicher in MiB (Standard: 64)\n");
+                        printf("  --imax=N     serve: maximale Iterationen der Kacheln (Standard: 255)\n");
+                        printf("  --port=N     worker: TCP Port (Standard: 9000)\n");
+                        printf("  --listen=A   worker: Adresse, z.B. 0.0.0.0 für entfernte Koordinatoren (Standard: 127.0.0.1)\n");
+                        printf("  --workers=L  distribute: Worker als host:port,host:port\n");
+                        printf("  --timeout=N  distribute: Sekunden ohne Antwort, bis ein Worker als ausgefallen gilt (Standard: 60)\n");
+                        printf("  --jobs=N     batch: gleichzeitig berechnete Aufträge (Standard: Anzahl der Threads)\n");
+                        printf("  --repeat=N   bench: gemessene Wiederholungen (Standard: 10)\n");
+                        printf("  --warmup=N   bench: verworfene Durchläufe vorab (Standard: 2)\n");
+                        printf("  --output=F   bench: CSV Datei der Ergebnisse (Standard: bench.csv)\n");
                         exit(EXIT_SUCCESS);
                 }
                 break;
@@ -65,22 +439,21 @@ int main(int argc, char *argv[])
         // Wenn Parameter und der Standarddateiname überschrieben werden sollen
         case 8:
                 file_name = argv[1];
-                r_start = (float)atof(argv[2]);
-                r_end = (float)atof(argv[3]);
-                i_start = (float)atof(argv[4]);
-                i_end = (float)atof(argv[5]);
-                resolution = (float)atof(argv[6]);
+                r_start = hp_parse(argv[2]);
+                r_end = hp_parse(argv[3]);
+                i_start = hp_parse(argv[4]);
+                i_end = hp_parse(argv[5]);
+                resolution = atof(argv[6]);
                 max_iterations = (float)atof(argv[7]);
-                strcat(file_name, ".bmp");
                 break;
 
         // Falls nur Parameter überschrieben werden sollen
         case 7:
-                r_start = (float)atof(argv[1]);
-                r_end = (float)atof(argv[2]);
-                i_start = (float)atof(argv[3]);
-                i_end = (float)atof(argv[4]);
-                resolution = (float)atof(argv[5]);
+                r_start = hp_parse(argv[1]);
+                r_end = hp_parse(argv[2]);
+                i_start = hp_parse(argv[3]);
+                i_end = hp_parse(argv[4]);
+                resolution = atof(argv[5]);
                 max_iterations = (float)atof(argv[6]);
                 break;
 
@@ -95,212 +468,215 @@ int main(int argc, char *argv[])
         // Eigentliche Berechnung wird mit den aktuellen Parametern durchgeführt
         // Ist eine Berechnung nicht möglich, wird das Programm mit einem Fehler
         // abgebrochen
-        exit(calculate_mandelbrot(file_name, r_start, r_end, i_start, i_end, resolution, max_iterations));
+        if (distributed)
+                exit(distribute(file_name, r_start, r_end, i_start, i_end, resolution, max_iterations, &options,
+                                &distribute_options));
+        if (animation)
+                exit(animate(file_name, r_start, r_end, i_start, i_end, resolution, max_iterations, &options, &animation_options, NULL));
+        exit(calculate_mandelbrot(file_name, r_start, r_end, i_start, i_end, resolution, max_iterations, &options));
 }
 
-// Eigentliche Methode zur Berechnung der Iterationszahlen der einzelnen komplexen
-// Zahlen korrespondierend zu Pixeln. Gibt entweder Fehlercode bei illegalen Werten
-// oder 0 bei Erfolg zurück
-int calculate_mandelbrot(char *file_name, float r_start, float r_end, float i_start, float i_end, float resolution, int16_t max_iterations)
+// option_value: Gibt den Wert der Option `name` zurück, falls argv[*index] diese
+// Option ist. Bei der Form "--name wert" wird *index auf den Wert weitergesetzt.
+// Fehlt der Wert, wird das Programm mit einem Fehler beendet
+static char *option_value(int argc, char *argv[], int *index, const char *name)
 {
-        // Die Resolution muss größer 0 sein, da sonst das Bild eine unendliche
-        // oder negative Größe hätte. Gibt Fehlermeldung aus
-        if (resolution <= 0)
+        char *arg = argv[*index];
+        size_t length = strlen(name);
+        if (strncmp(arg, "--", 2) || strncmp(arg + 2, name, length))
+                return NULL;
+
+        if (arg[2 + length] == '=')
+                return arg + 3 + length;
+
+        if (arg[2 + length] != '\0')
+                return NULL;
+
+        if (*index + 1 >= argc)
         {
-                fprintf(stderr, "   Die Resolution darf nicht negativ oder 0 sein.\r\n");
+                fprintf(stderr, "Die Option '%s' benötigt einen Wert.\r\n", arg);
                 fflush(stderr);
-                return EXIT_FAILURE;
+                exit(EXIT_FAILURE);
         }
+        return argv[++*index];
+}
 
-        // Anzahl maximaler Iterationen darf nicht kleiner 0 sein. Eine ungewollt
-        // negative Eingabe könnte bei unsigned Integern zu ungewollt hohen
-        // Iterationsanzahlen führen. Gibt Fehlermeldung aus
-        if (max_iterations < 0)
+// report_pass: Meldet jede Vorschau des progressiven Modus mit der seit dem Start
+// vergangenen Zeit. user zeigt auf den Startzeitpunkt
+static _Bool report_pass(void *user, unsigned pass, const render_tile *image)
+{
+        (void)image;
+        printf("   Vorschau %u von %d nach %f Sekunden.\r\n", pass + 1, RENDER_PASSES, curtime() - *(const double *)user);
+        fflush(stdout);
+        return 1;
+}
+
+// compare_times: Vergleichsfunktion für qsort zum Sortieren der Kachelzeiten
+static int compare_times(const void *a, const void *b)
+{
+        uint64_t x = *(const uint64_t *)a;
+        uint64_t y = *(const uint64_t *)b;
+        return (x > y) - (x < y);
+}
+
+// print_stats: Gibt die Messwerte des Stats-Modus als Tabelle aus. time ist die
+// Gesamtdauer des Auftrags
+static void print_stats(const render_stats *stats, double time, const char *path)
+{
+        uint64_t pixels = stats->width * stats->height;
+        printf("   Messwerte:\r\n");
+        printf("     Berechnung:        %10.6f s (%5.1f Prozent)\r\n", stats->render_time, 100.0 * stats->render_time / time);
+        printf("     Einfärben:         %10.6f s (%5.1f Prozent)\r\n", stats->color_time, 100.0 * stats->color_time / time);
+        printf("     Schreiben:         %10.6f s (%5.1f Prozent)\r\n", stats->write_time, 100.0 * stats->write_time / time);
+        printf("     Kernelaufrufe:     %10" PRIu64 " mit %" PRIu64 " Pixeln\r\n", stats->calls, stats->pixels);
+        printf("     Iterationen:       %10" PRIu64 " (%.1f je berechnetem Pixel)\r\n", stats->iterations,
+               stats->pixels > 0 ? (double)stats->iterations / (double)stats->pixels : 0.0);
+        printf("     Vektorelemente:    %10" PRIu64 " Iterationen in Gruppen zu %" PRIu64 ", davon %.1f Prozent genutzt\r\n",
+               stats->lane_iterations, stats->lanes,
+               stats->lane_iterations > 0 ? 100.0 * (double)stats->iterations / (double)stats->lane_iterations : 100.0);
+
+        // Verteilung der Kernelzeit auf die Kacheln
+        uint64_t cells = stats->columns * stats->rows;
+        uint64_t *sorted = malloc(cells * sizeof(uint64_t));
+        if (sorted != NULL)
         {
-                fprintf(stderr, "   Die Anzahl der maximalen Iterationen darf nicht kleiner 0 sein.\r\n");
-                fflush(stderr);
-                return EXIT_FAILURE;
+                memcpy(sorted, stats->cell_time, cells * sizeof(uint64_t));
+                qsort(sorted, cells, sizeof(uint64_t), compare_times);
+                uint64_t slowest = 0;
+                for (uint64_t c = 1; c < cells; c++)
+                {
+                        if (stats->cell_time[c] > stats->cell_time[slowest])
+                                slowest = c;
+                }
+                printf("     Kacheln:           %10" PRIu64 " mit %f / %f / %f ms (Minimum / Median / Maximum), langsamste in Spalte %" PRIu64 ", Zeile %" PRIu64 "\r\n",
+                       cells, sorted[0] * 1e-6, sorted[cells / 2] * 1e-6, sorted[cells - 1] * 1e-6,
+                       slowest % stats->columns, slowest / stats->columns);
+                free(sorted);
         }
 
-        // Liegt die Eingabe für r_start nicht innerhalb des Intervalls [-2;1]
-        // würden zu viele sinnlose Berechnung durchgeführt werden
-        // Gleiches wird für die übrigen Abmessungsparameter überprüft
-        // Gibt Fehlermeldung aus.
-        if (r_start < -2 || r_start > 1)
+        // Histogramm der Iterationszähler, leere Klassen werden ausgelassen
+        printf("     Iterationszähler:\r\n");
+        for (unsigned b = 0; b < RENDER_STATS_BUCKETS; b++)
         {
-                fprintf(stderr, "   Die Eingabe für r_start muss im Interval [-2;1] liegen.\r\n");
-                fflush(stderr);
-                return EXIT_FAILURE;
+                if (stats->histogram[b] == 0)
+                        continue;
+                char label[32];
+                if (b == RENDER_STATS_BUCKETS - 1)
+                        snprintf(label, sizeof(label), "Menge");
+                else if (b < 2)
+                        snprintf(label, sizeof(label), "%u", b);
+                else
+                        snprintf(label, sizeof(label), "%u-%u", 1u << (b - 1), (1u << b) - 1);
+                printf("       %-16s %10" PRIu64 " (%5.1f Prozent)\r\n", label, stats->histogram[b],
+                       100.0 * (double)stats->histogram[b] / (double)pixels);
         }
+        printf("   Zeitkarte \"%s\" mit %" PRIu64 " x %" PRIu64 " Kacheln wurde erzeugt.\r\n", path, stats->columns, stats->rows);
+        fflush(stdout);
+}
 
-        if (r_end < -2 || r_end > 1)
+// Eigentliche Methode zur Berechnung der Iterationszahlen der einzelnen komplexen
+// Zahlen korrespondierend zu Pixeln. Dünner Aufrufer des Rechenkontexts (s. context.h),
+// der die Ergebnisse und Fehler ausgibt. Gibt entweder Fehlercode bei illegalen
+// Werten oder 0 bei Erfolg zurück
+int calculate_mandelbrot(char *file_name, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end, double resolution,
+                         int16_t max_iterations, const render_options *options)
+{
+        render_context *context = render_context_create(options);
+        if (context == NULL)
         {
-                fprintf(stderr, "   Die Eingabe für r_end muss im Interval [-2;1] liegen.\r\n");
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
                 fflush(stderr);
                 return EXIT_FAILURE;
         }
 
-        if (i_start < -1 || i_start > 1)
+        render_request request = {
+            .r_start = r_start,
+            .r_end = r_end,
+            .i_start = i_start,
+            .i_end = i_end,
+            .resolution = resolution,
+            .max_iterations = max_iterations,
+            .sink = {.file_name = file_name},
+        };
+        double start = curtime();
+        if (options->progressive)
         {
-                fprintf(stderr, "   Die Eingabe für i_start muss im Interval [-1;1] liegen.\r\n");
+                request.sink.pass = report_pass;
+                request.sink.user = &start;
+        }
+        render_result result;
+        if (render_context_run(context, &request, &result) != RENDER_OK)
+        {
+                fprintf(stderr, "   %s\r\n", render_context_error(context));
                 fflush(stderr);
+                render_context_destroy(context);
                 return EXIT_FAILURE;
         }
 
-        if (i_end < -1 || i_end > 1)
+        if (options->verify != VERIFY_OFF && !result.verified)
         {
-                fprintf(stderr, "   Die Eingabe für i_end muss im Interval [-1;1] liegen.\r\n");
+                fprintf(stderr, "   Test kann wegen Speichermangel nicht durchgeführt werden.\r\n");
                 fflush(stderr);
-                return EXIT_FAILURE;
         }
-
-        // Berechnung der Höhe und Breite des Bildes und Verkleinerung auf
-        // Vielfaches von 4. Für Optimierung in Assembly Implementierung
-        u_int32_t width = (r_end - r_start) / resolution;
-        width = width - (width % 4);
-        u_int32_t height = (i_end - i_start) / resolution;
-        height = height - (height % 4);
-
-        // Höhe und Breite des Bildes dürfen nicht negativ sein und keinen
-        // Integer Overflow erzeugen, sobald sie zur Bildgröße zusammengerechnet
-        // werden
-        if (width <= 0 || height <= 0 || ((width * height) * 3) / height != width * 3)
+        if (options->cache_path != NULL && !result.cached)
         {
-                fprintf(stderr, "   Mit den eingegebenen Parametern kann keine Berechnung durchgeführt werden.\r\n");
+                fprintf(stderr, "   Der Kachel-Cache %s konnte nicht geöffnet werden.\r\n", options->cache_path);
                 fflush(stderr);
-                return EXIT_FAILURE;
         }
 
-        // Berechnung der Anzahl der benötigten Bytes der zu erzeugenden Bilddatei
-        int32_t imageSize = width * height * 3;
+        printf("   Die Berechnung hat %f Sekunden gedauert (%u Threads, Kernel %s, Genauigkeit %s, Modus %s).\r\n",
+               result.time, options->threads, kernel_name(result.kernel), precision_name(result.precision),
+               render_mode_name(options->mode));
+        fflush(stdout);
 
-        // Zur Sicherheit darf die erzeugte Datei nicht größer als 1.5 Gigabyte
-        // und nicht kleiner als 0 Byte sein. Gibt Fehlermeldung aus
-        if (imageSize > 1500000000 && imageSize < 0)
+        if (result.cached)
         {
-                fprintf(stderr, "   Die zu erzeugende Datei ist zu groß. Bitte benutzen Sie kleinere Parameter für den Wertebereich.\r\n");
-                fflush(stderr);
-                return EXIT_FAILURE;
+                // Ausgabe der aus dem Cache übernommenen und der neu berechneten Kacheln
+                printf("   Kachel-Cache: %" PRIu64 " Treffer, %" PRIu64 " Fehlschläge.\r\n", result.cache_hits, result.cache_misses);
+                fflush(stdout);
         }
 
-        // Definition von File und Info Header für die zu erzeugende Bitmap Datei
-        BITMAPFILEHEADER bmFH;
-        BITMAPINFOHEADER bmIH;
-
-        // Bitmap Dateien müssen 4 Byte aligned sein, falls diese das nicht sind,
-        // wird ein Puffer an das Ende der Zeile geschrieben, der diese 4 Byte
-        // auffüllt
-        int32_t paddingSize = (4 - (sizeof(RGBTRIPLET) * width) % 4) % 4;
-
-        // Berechnung der totalen Bildgröße aus der totalen Größe des Headers, der
-        // Bildgröße und des benötigten Puffers
-        int32_t fileSize = sizeof(bmFH) + sizeof(bmIH) + imageSize + (3 * width * paddingSize);
-
-        // Schreiben der benötigten Daten in den File Header
-        bmFH.bfType = 0x4d42;
-        bmFH.bfSize = fileSize;
-        bmFH.bfReserved1 = 0;
-        bmFH.bfReserved2 = 0;
-        bmFH.bfOffBits = sizeof(bmFH) + sizeof(bmIH);
-
-        // Schreiben der benötigten Daten in den Info Header
-        bmIH.biSize = sizeof(bmIH);
-        bmIH.biWidth = width;
-        bmIH.biHeight = height;
-        bmIH.biPlanes = 0;
-        bmIH.biBitCount = 24;
-        bmIH.biCompression = 0;
-        bmIH.biSizeImage = imageSize;
-        bmIH.biXPelsPerMeter = 0;
-        bmIH.biYPelsPerMeter = 0;
-        bmIH.biClrUsed = 0;
-        bmIH.biClrImportant = 0;
-
-        // Pointer auf Anfang einer Datei wird erstellt, die bei nicht-
-        // Existenz neu erstellt oder bei Existenz geleert wird.
-        FILE *fp = fopen(file_name, "wb");
-
-        // Konnte die Datei nicht geöffnet werden,
-        // bricht das Programm ab.
-        if (fp == NULL)
-        {
-                fprintf(stderr, "   Die Datei %s.bmp konnte nicht erstellt werden.\r\n", file_name);
-                fflush(stderr);
-                return EXIT_FAILURE;
+        if (options->antialias > 1)
+        {
+                // Anteil der geglätteten Pixel, von dem der Mehraufwand abhängt
+                printf("   Kantenglättung: %" PRIu64 " Randpixel (%f Prozent) mit je %u Stichproben.\r\n", result.supersampled,
+                       100.0 * result.supersampled / (result.width * result.height), options->antialias * options->antialias);
+                fflush(stdout);
         }
 
-        // Speicher für die Pixel Bytes reservieren
-        uint8_t *buffer = (uint8_t *)malloc(imageSize);
-
-        // Wenn der der Speicher für den Buffer nicht allokiert
-        // werden konnte, bricht das Programm ab
-        if (buffer == NULL)
+        if (options->mirror && result.unmirrored != NULL)
         {
-                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
-                return EXIT_FAILURE;
+                // Grund, warum alle Zeilen berechnet wurden
+                printf("   Spiegelung nicht aktiv: %s\r\n", result.unmirrored);
+                fflush(stdout);
         }
-
-        // Messung der zur Ausführung benötigten Zeit und tatsächliche Ausführung der
-        // Berechnung durch die Assembly Implementierung
-        double time = curtime();
-        mandelbrot(r_start, r_end, i_start, i_end, resolution, buffer, max_iterations);
-        time = curtime() - time;
-        printf("   Die Berechnung hat %f Sekunden gedauert.\r\n", time);
-        fflush(stdout);
-
-        // Schreibt die Header Daten in den Buffer der Bilddatei
-        fwrite(&bmFH, sizeof(bmFH), 1, fp);
-        fwrite(&bmIH, sizeof(bmIH), 1, fp);
-
-        // Schreibt die generierten Pixeldaten in den Buffer der Bilddatei
-        fwrite((uint8_t *)buffer, 3, imageSize, fp);
-
-        // Wenn die Bilddatei nicht geschlossen werden konnte, wird eine
-        // Fehlermeldung ausgegeben
-        if (fclose(fp))
+        else if (options->mirror)
         {
-                fprintf(stderr, "   Die Datei %s.bmp konnte nicht geschlossen werden.\r\n", file_name);
-                fflush(stderr);
-                free(buffer);
-                return EXIT_FAILURE;
+                // Anteil der nicht berechneten Zeilen
+                printf("   Spiegelung: %" PRIu64 " von %" PRIu64 " Zeilen (%f Prozent) an der reellen Achse gespiegelt.\r\n",
+                       result.mirrored, result.height, 100.0 * result.mirrored / result.height);
+                fflush(stdout);
         }
 
-        // Wenn noch genug Speicher reserviert werden kann, wird die Ähnlichkeit zu
-        // der Ausgabe des Referenzprogrammes berechnet und ausgegeben.
-        //
-        // Dieser Vorgang dient der Überprüfung der Korrektheit des Programms.
-        // Die Interpretation des Ähnlichkeitswertes obliegt dem Nutzer, jedoch
-        // wird ein Wert über 99% als Korrekt interpretiert.
-        uint8_t *comparisonBuffer = (uint8_t *)malloc(imageSize);
-        if (comparisonBuffer != NULL)
+        uint64_t width = result.width;
+        if (result.verified && options->verify == VERIFY_SAMPLED)
+        {
+                // Ausgabe des Anteils abweichender Pixel in den geprüften Zeilen
+                printf("   Stichprobe von %" PRIu64 " der %" PRIu64 " Zeilen: %" PRIu64 " von %" PRIu64 " Pixeln (%f Prozent) weichen von der Referenzimplementierung ab.\r\n",
+                       result.compared_rows, result.height, result.mismatches, result.compared_rows * width,
+                       100.0 * (double)result.mismatches / (double)(result.compared_rows * width));
+                fflush(stdout);
+        }
+        else if (result.verified)
         {
-
-                // Berechnung der von Referenzprogramm benötigten Zeit und Ausführung
-                // des Referenzprogrammes
-                double c_time = curtime();
-                mandelbrot_c(r_start, r_end, i_start, i_end, resolution,
-                             comparisonBuffer, max_iterations);
-                c_time = curtime() - c_time;
-
-                // Iteration über tatsächliches und erwartetes Bild. Für jeden
-                // Unterschied an beiden Bildern wird ein Zähler inkrementiert
-                u_int32_t counter = 0;
-                for (int i = 0; i < imageSize; i += 3)
-                {
-                        if ((*(buffer + i) != *(comparisonBuffer + i)))
-                        {
-                                counter++;
-                        }
-                }
-
                 // Ausgabe der Ähnlichkeit der beiden Bilder
                 printf("   Die Ähnlichkeit zur Referenzimplementierung beträgt %f Prozent.\r\n",
-                       100.0 - ((float)counter / (float)(imageSize / 3.0)));
+                       100.0 - 100.0 * (double)result.mismatches / (double)(result.compared_rows * width));
                 fflush(stdout);
 
                 // Berechnung der Zeitdifferenz von Assembly- und Referenzimplementierung und
                 // Ausgabe von dieser Abhängig davon, welche Implementierung schneller war
-                double time_dif = c_time - time;
+                double time_dif = result.reference_time - result.time;
                 if (time_dif > 0)
                 {
                         printf("   Assembly Implementierung ist um %f Sekunden schneller als das C Referenzprogramm.\r\n", time_dif);
@@ -315,20 +691,14 @@ int calculate_mandelbrot(char *file_name, float r_start, float r_end, float i_st
                         printf("   Beide Implementierungen sind gleich schnell.\r\n");
                 }
                 fflush(stdout);
-
-                // Freigeben des für das Referenzbild allokierten Speichers zur
-                // Verhinderung von Memory Leaks
-                free(comparisonBuffer);
-        }
-        else
-        {
-                fprintf(stderr, "   Test kann wegen Speichermangel nicht durchgeführt werden.\r\n");
         }
 
-        // Freigeben des für das echte Bild allokierten Speichers zur
-        // Verhinderung von Memory Leaks
-        free(buffer);
-        printf("   Bild \"%s\" wurde erfolgreich erzeugt.\r\n", file_name);
+        if (result.stats != NULL)
+                print_stats(result.stats, result.time + result.stats->write_time, options->stats_path);
+
+        for (unsigned p = 0; p < result.file_count; p++)
+                printf("   Bild \"%s\" wurde erfolgreich erzeugt.\r\n", result.paths[p]);
+        render_context_destroy(context);
         return EXIT_SUCCESS;
 }
 
@@ -447,12 +817,114 @@ int test()
         }
         printf("Test 11) erfolgreich!\r\n\r\n");
 
+        animation_settings zoom = {.frames = 5, .r_start = -0.8, .r_end = -0.7, .i_start = 0, .i_end = 0.1, .has_end = 1};
+        if (!test_reuse(12, "./mandelbrot animate f -2 1 -1 1 0.005 200 --to=-0.8,-0.7,0,0.1 --frames=5",
+                        -2, 1, -1, 1, 0.005, 200, &zoom, 0))
+        {
+                printf("Test 12) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 12) erfolgreich!\r\n\r\n");
+
+        animation_settings pan = {.frames = 5, .r_start = -2, .r_end = 0.9, .i_start = -1, .i_end = 0.9, .has_end = 1};
+        if (!test_reuse(13, "./mandelbrot animate f -1.9 1 -0.9 1 0.005 200 --to=-2,0.9,-1,0.9 --frames=5",
+                        -1.9, 1, -0.9, 1, 0.005, 200, &pan, 1))
+        {
+                printf("Test 13) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 13) erfolgreich!\r\n\r\n");
+
+        if (!test_mirror(14, "./mandelbrot -2 1 -1 1 0.005 255 --kernel=sse", -2, 1, -1, 1, 0.005, 255, KERNEL_SSE,
+                         PRECISION_FLOAT))
+        {
+                printf("Test 14) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 14) erfolgreich!\r\n\r\n");
+
+        if (!test_mirror(15, "./mandelbrot -2 1 -0.9 0.63 0.004 500 --kernel=c --precision=double", -2, 1, -0.9, 0.63,
+                         0.004, 500, KERNEL_C, PRECISION_DOUBLE))
+        {
+                printf("Test 15) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 15) erfolgreich!\r\n\r\n");
+
+        if (!test_stats(16, "./mandelbrot -2 1 -1 1 0.002 1000 --stats=test_stats.csv", -2, 1, -1, 1, 0.002, 1000))
+        {
+                printf("Test 16) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 16) erfolgreich!\r\n\r\n");
+
+        // Die Abkürzungen des SSE Kernels (Kardioide, Kreis der Periode 2, Zyklenerkennung)
+        // gegen die Referenz ohne Abkürzungen, die dieselben Rechenschritte ohne FMA ausführt
+        if (!test_verify(17, "./mandelbrot -0.8 0.4 -0.6 0.6 0.004 3000 --kernel=sse --verify=full", -0.8, 0.4, -0.6, 0.6,
+                         0.004, 3000, KERNEL_SSE, PRECISION_FLOAT, RENDER_MODE_SCAN))
+        {
+                printf("Test 17) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 17) erfolgreich!\r\n\r\n");
+
+        if (!test_verify(18, "./mandelbrot -1.3 -0.7 -0.3 0.3 0.002 3000 --kernel=sse --precision=double --verify=full", -1.3,
+                         -0.7, -0.3, 0.3, 0.002, 3000, KERNEL_SSE, PRECISION_DOUBLE, RENDER_MODE_SCAN))
+        {
+                printf("Test 18) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 18) erfolgreich!\r\n\r\n");
+
+        if (!test_verify(19, "./mandelbrot -0.8 -0.7 0.05 0.15 0.0004 3000 --kernel=sse --verify=full", -0.8, -0.7, 0.05,
+                         0.15, 0.0004, 3000, KERNEL_SSE, PRECISION_FLOAT, RENDER_MODE_SCAN))
+        {
+                printf("Test 19) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 19) erfolgreich!\r\n\r\n");
+
+        if (!test_verify(20, "./mandelbrot -0.75 -0.73 0.1 0.12 0.00002 1000 --kernel=sse --mode=subdivide --verify=full",
+                         -0.75, -0.73, 0.1, 0.12, 0.00002, 1000, KERNEL_SSE, PRECISION_AUTO, RENDER_MODE_SUBDIVIDE))
+        {
+                printf("Test 20) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 20) erfolgreich!\r\n\r\n");
+
+        if (!test_mirror_reason(21, "./mandelbrot -2 1 -0.9 0.63 0.004 500 --mirror=on", -2, 1, -0.9, 0.63, 0.004, 500, 1))
+        {
+                printf("Test 21) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 21) erfolgreich!\r\n\r\n");
+
+        // Die Achse liegt eine halbe Zeile neben Zeile 225
+        if (!test_mirror_reason(22, "./mandelbrot -2 1 -0.902 0.63 0.004 500 --mirror=on", -2, 1, -0.902, 0.63, 0.004, 500,
+                                0))
+        {
+                printf("Test 22) fehlgeschlagen! Abbrechen...\r\n");
+                fflush(stdout);
+                return EXIT_FAILURE;
+        }
+        printf("Test 22) erfolgreich!\r\n\r\n");
+
         printf("Zur Verifikation von validen Eingaben werden unter anderem folgende Parameterübergaben empfohlen:\r\n");
         printf("   ./mandelbrot -2 1 -1 1 0.001 510\r\n");
         printf("   ./mandelbrot 0.25 0.5 0.25 0.5 0.0005 510\r\n");
         printf("   ./mandelbrot -2 -1 -1 0 0.05 127\r\n");
         printf("   ./mandelbrot -2 1 -1 1 0.005 5000\r\n");
-        printf("Der Vergleich zur Referenzimplementierung erfolgt automatisch.\r\n");
+        printf("Der Vergleich zur Referenzimplementierung erfolgt automatisch (vollständig mit --verify=full).\r\n");
 
         fflush(stdout);
         return EXIT_SUCCESS;
@@ -470,67 +942,306 @@ _Bool test_input(int index, char *input, char *expected, float r_start, float r_
         printf("Erwartet:\r\n%s\r\n", expected);
         printf("Tatsächlich:\r\n");
         fflush(stdout);
-        return calculate_mandelbrot("mandelbrot", r_start, r_end, i_start, i_end, resolution, max_iterations);
+        render_options options = {
+            .threads = 1,
+            .tile_size = 64,
+            .kernel = KERNEL_AUTO,
+            .precision = PRECISION_AUTO,
+            .strip_height = 256,
+            .format = IMAGE_FORMAT_AUTO,
+            .mode = RENDER_MODE_SCAN,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_OFF,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+        };
+        return calculate_mandelbrot("mandelbrot", r_start, r_end, i_start, i_end, resolution, max_iterations, &options);
 }
 
-// Statische Methode zur Rückgabe der aktuellen Zeit
-static double curtime(void)
+// test_reuse: Erzeugt die Animation einmal mit --reuse=on und einmal mit --reuse=off
+// und vergleicht die Bilder byteweise. Die Bilder werden anschließend gelöscht. Bei einer
+// Verschiebung (pan) muss mindestens eine Kachel übernommen worden sein.
+// Gibt einen Wahrheitswert darüber aussagend zurück, ob alle Bilder übereinstimmen
+_Bool test_reuse(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                 double resolution, int16_t max_iterations, const animation_settings *settings, _Bool pan)
 {
-        struct timespec t;
-        clock_gettime(CLOCK_MONOTONIC, &t);
-        return t.tv_sec + t.tv_nsec * 1e-9f;
+        printf("%d) Test\r\n", index);
+        printf("Input: %s mit --reuse=on und --reuse=off\r\n", input);
+        printf("Erwartet:\r\nIdentische Bilder\r\n");
+        printf("Tatsächlich:\r\n");
+        fflush(stdout);
+        render_options options = {
+            .threads = 1,
+            .tile_size = 64,
+            .kernel = KERNEL_AUTO,
+            .precision = PRECISION_AUTO,
+            .strip_height = 256,
+            .format = IMAGE_FORMAT_BMP8,
+            .mode = RENDER_MODE_SCAN,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_OFF,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+        };
+        animation_settings reuse = *settings;
+        reuse.reuse = 1;
+        animation_settings compute = *settings;
+        compute.reuse = 0;
+        uint64_t reused = 0;
+        _Bool same = animate("test_reuse_on", r_start, r_end, i_start, i_end, resolution, max_iterations, &options, &reuse,
+                             &reused) == EXIT_SUCCESS &&
+                     animate("test_reuse_off", r_start, r_end, i_start, i_end, resolution, max_iterations, &options,
+                             &compute, NULL) == EXIT_SUCCESS;
+
+        // Verschiebungen müssen Kacheln übernehmen, sonst prüft der Vergleich nur die Berechnung
+        if (same && pan && reused == 0)
+        {
+                printf("   Es wurden keine Kacheln übernommen.\r\n");
+                same = 0;
+        }
+
+        for (uint64_t frame = 0; frame < settings->frames; frame++)
+        {
+                char paths[2][64];
+                snprintf(paths[0], sizeof(paths[0]), "test_reuse_on_%04" PRIu64 "%s", frame,
+                         image_format_extension(options.format));
+                snprintf(paths[1], sizeof(paths[1]), "test_reuse_off_%04" PRIu64 "%s", frame,
+                         image_format_extension(options.format));
+                if (same && !files_equal(paths[0], paths[1]))
+                {
+                        printf("   Bild %" PRIu64 " weicht ab.\r\n", frame);
+                        same = 0;
+                }
+                remove(paths[0]);
+                remove(paths[1]);
+        }
+        fflush(stdout);
+        return same;
 }
 
-// mandelbrot_c: Referenzimplementierung des in Assembly zu implementierenden Algorithmus
-// zur Berechnung und Visualisierung der Mandelbrotmenge. Funktionsweise und Dokumentation
-// des Algorithmus ist der Dokumentation zu entnehmen.
-void mandelbrot_c(float r_start, float r_end, float i_start, float i_end, float resolution, unsigned char *img, int16_t max_iterations)
+// test_mirror: Berechnet das Bild einmal mit --mirror=on und einmal mit --mirror=off und
+// vergleicht die Dateien byteweise. Die Dateien werden anschließend gelöscht.
+// Gibt einen Wahrheitswert darüber aussagend zurück, ob beide übereinstimmen
+_Bool test_mirror(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                  double resolution, int16_t max_iterations, kernel_variant kernel, precision_tier precision)
 {
-        u_int8_t colorscheme[36] = {205, 116, 24, 238, 134, 28, 255, 144, 30, 34, 180, 238, 37, 193, 255, 0, 215, 255, 0, 102, 205, 0, 118, 238, 0, 127, 255, 44, 44, 238};
-        int16_t iteration_counter;
-        float last_Re, last_Im;
-        float imaginary_progress = i_start;
-        float real_progress = r_start;
-        u_int32_t x, y;
-        u_int32_t width = (r_end - r_start) / resolution;
-        width = width - (width % 4);
-        u_int32_t height = (i_end - i_start) / resolution;
-        height = height - (height % 4);
-        y = 0;
-        while (y < height)
-        {
-                real_progress = (double)r_start;
-                x = 0;
-                while (x < width)
-                {
-                        iteration_counter = 0;
-                        last_Re = 0;
-                        last_Im = 0;
-                        while (iteration_counter < max_iterations)
-                        {
-                                float tmp_Re = last_Re;
-                                float tmp_Im = last_Im;
-                                last_Re = tmp_Re * tmp_Re - tmp_Im * tmp_Im + real_progress;
-                                last_Im = (2 * tmp_Re * tmp_Im) + imaginary_progress;
-                                if (!((last_Re * last_Re + last_Im * last_Im) < 4))
-                                        break;
-                                iteration_counter++;
-                        }
-                        if (iteration_counter != max_iterations)
-                        {
-                                u_int8_t color = (iteration_counter % max_iterations) % 10;
-                                *(img++) = colorscheme[3 * (color) + 0];
-                                *(img++) = colorscheme[3 * (color) + 1];
-                                *(img++) = colorscheme[3 * (color) + 2];
-                        }
-                        else
-                        {
-                                img += 3;
-                        }
-                        real_progress += resolution;
-                        x++;
-                }
-                imaginary_progress += resolution;
-                y++;
+        printf("%d) Test\r\n", index);
+        printf("Input: %s mit --mirror=on und --mirror=off\r\n", input);
+        printf("Erwartet:\r\nIdentische Bilder\r\n");
+        printf("Tatsächlich:\r\n");
+        fflush(stdout);
+        render_options options = {
+            .threads = 1,
+            .tile_size = 64,
+            .kernel = kernel,
+            .precision = precision,
+            .strip_height = 64,
+            .format = IMAGE_FORMAT_BMP8,
+            .mode = RENDER_MODE_SCAN,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_OFF,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+            .mirror = 1,
+        };
+        _Bool same = calculate_mandelbrot("test_mirror_on", r_start, r_end, i_start, i_end, resolution, max_iterations,
+                                          &options) == EXIT_SUCCESS;
+        options.mirror = 0;
+        same = calculate_mandelbrot("test_mirror_off", r_start, r_end, i_start, i_end, resolution, max_iterations,
+                                    &options) == EXIT_SUCCESS &&
+               same;
+
+        char paths[2][64];
+        snprintf(paths[0], sizeof(paths[0]), "test_mirror_on%s", image_format_extension(options.format));
+        snprintf(paths[1], sizeof(paths[1]), "test_mirror_off%s", image_format_extension(options.format));
+        if (same && !files_equal(paths[0], paths[1]))
+        {
+                printf("   Die Bilder weichen ab.\r\n");
+                same = 0;
+        }
+        remove(paths[0]);
+        remove(paths[1]);
+        fflush(stdout);
+        return same;
+}
+
+// test_mirror_reason: Berechnet das Bild mit --mirror=on und erwartet bei mirrored
+// gespiegelte Zeilen und keinen Grund, sonst keine gespiegelte Zeile und einen Grund.
+// Die Datei wird anschließend gelöscht.
+// Gibt einen Wahrheitswert darüber aussagend zurück, ob das Ergebnis der Erwartung entspricht
+_Bool test_mirror_reason(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                         double resolution, int16_t max_iterations, _Bool mirrored)
+{
+        printf("%d) Test\r\n", index);
+        printf("Input: %s\r\n", input);
+        printf("Erwartet:\r\n   %s\r\n", mirrored ? "Gespiegelte Zeilen" : "Keine gespiegelte Zeile und ein Grund dafür");
+        printf("Tatsächlich:\r\n");
+        fflush(stdout);
+        render_options options = {
+            .threads = 1,
+            .tile_size = 64,
+            .kernel = KERNEL_C,
+            .precision = PRECISION_AUTO,
+            .strip_height = 64,
+            .format = IMAGE_FORMAT_BMP8,
+            .mode = RENDER_MODE_SCAN,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_OFF,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+            .mirror = 1,
+        };
+        render_request request = {
+            .r_start = r_start,
+            .r_end = r_end,
+            .i_start = i_start,
+            .i_end = i_end,
+            .resolution = resolution,
+            .max_iterations = max_iterations,
+            .sink = {.file_name = "test_mirror_reason"},
+        };
+        render_context *context = render_context_create(&options);
+        render_result result;
+        _Bool expected = context != NULL && render_context_run(context, &request, &result) == RENDER_OK;
+        if (expected)
+        {
+                printf("   %" PRIu64 " gespiegelte Zeilen, Grund: %s\r\n", result.mirrored,
+                       result.unmirrored != NULL ? result.unmirrored : "-");
+                expected = mirrored ? result.mirrored > 0 && result.unmirrored == NULL
+                                    : result.mirrored == 0 && result.unmirrored != NULL;
+                for (unsigned p = 0; p < result.file_count; p++)
+                        remove(result.paths[p]);
+        }
+        if (context != NULL)
+                render_context_destroy(context);
+        fflush(stdout);
+        return expected;
+}
+
+// test_stats: Berechnet das Bild mit --stats in einem Thread und prüft, ob die Zeiten
+// plausibel sind: Berechnung, Einfärben und Schreiben dauern messbar lange, die Berechnung
+// macht den Großteil der Gesamtzeit aus und die Kernelzeiten der Zeitkarte passen in sie.
+// Die Dateien werden anschließend gelöscht.
+// Gibt einen Wahrheitswert darüber aussagend zurück, ob alle Zeiten plausibel sind
+_Bool test_stats(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                 double resolution, int16_t max_iterations)
+{
+        printf("%d) Test\r\n", index);
+        printf("Input: %s\r\n", input);
+        printf("Erwartet:\r\nPlausible Zeiten\r\n");
+        printf("Tatsächlich:\r\n");
+        fflush(stdout);
+        render_options options = {
+            .threads = 1,
+            .tile_size = 64,
+            .kernel = KERNEL_AUTO,
+            .precision = PRECISION_AUTO,
+            .strip_height = 256,
+            .format = IMAGE_FORMAT_BMP8,
+            .mode = RENDER_MODE_SCAN,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_OFF,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+            .stats_path = "test_stats.csv",
+        };
+        render_request request = {
+            .r_start = r_start,
+            .r_end = r_end,
+            .i_start = i_start,
+            .i_end = i_end,
+            .resolution = resolution,
+            .max_iterations = max_iterations,
+            .sink = {.file_name = "test_stats"},
+        };
+        render_context *context = render_context_create(&options);
+        render_result result;
+        _Bool plausible = context != NULL && render_context_run(context, &request, &result) == RENDER_OK &&
+                          result.stats != NULL;
+        if (plausible)
+        {
+                const render_stats *stats = result.stats;
+                double kernel_time = 0;
+                for (uint64_t c = 0; c < stats->columns * stats->rows; c++)
+                        kernel_time += stats->cell_time[c] * 1e-9;
+                printf("   Gesamt %f s, Berechnung %f s, Kernel %f s, Einfärben %f s, Schreiben %f s.\r\n", result.time,
+                       stats->render_time, kernel_time, stats->color_time, stats->write_time);
+                plausible = stats->render_time > 0 && stats->color_time > 0 && stats->write_time > 0 &&
+                            stats->render_time <= result.time && stats->render_time >= 0.5 * result.time &&
+                            kernel_time > 0.5 * stats->render_time && kernel_time <= stats->render_time;
+                for (unsigned p = 0; p < result.file_count; p++)
+                        remove(result.paths[p]);
+        }
+        if (context != NULL)
+                render_context_destroy(context);
+        remove(options.stats_path);
+        fflush(stdout);
+        return plausible;
+}
+
+// test_verify: Berechnet das Bild mit --verify=full und erwartet keine Abweichung von
+// der Referenzimplementierung. Die Datei wird anschließend gelöscht.
+// Gibt einen Wahrheitswert darüber aussagend zurück, ob alle Pixel übereinstimmen
+_Bool test_verify(int index, char *input, hp_float r_start, hp_float r_end, hp_float i_start, hp_float i_end,
+                  double resolution, int16_t max_iterations, kernel_variant kernel, precision_tier precision,
+                  render_mode mode)
+{
+        printf("%d) Test\r\n", index);
+        printf("Input: %s\r\n", input);
+        printf("Erwartet:\r\n   0 abweichende Pixel\r\n");
+        printf("Tatsächlich:\r\n");
+        fflush(stdout);
+        render_options options = {
+            .threads = 1,
+            .tile_size = 64,
+            .kernel = kernel,
+            .precision = precision,
+            .strip_height = 256,
+            .format = IMAGE_FORMAT_BMP8,
+            .mode = mode,
+            .lanes = LANES_UNROLL,
+            .verify = VERIFY_FULL,
+            .palettes = {PALETTE_CLASSIC},
+            .palette_count = 1,
+        };
+        render_request request = {
+            .r_start = r_start,
+            .r_end = r_end,
+            .i_start = i_start,
+            .i_end = i_end,
+            .resolution = resolution,
+            .max_iterations = max_iterations,
+            .sink = {.file_name = "test_verify"},
+        };
+        render_context *context = render_context_create(&options);
+        render_result result;
+        _Bool equal = context != NULL && render_context_run(context, &request, &result) == RENDER_OK && result.verified;
+        if (equal)
+        {
+                printf("   %" PRIu64 " abweichende Pixel\r\n", result.mismatches);
+                equal = result.mismatches == 0;
+                for (unsigned p = 0; p < result.file_count; p++)
+                        remove(result.paths[p]);
+        }
+        if (context != NULL)
+                render_context_destroy(context);
+        fflush(stdout);
+        return equal;
+}
+
+// files_equal: Gibt zurück, ob beide Dateien geöffnet werden konnten und denselben Inhalt haben
+static _Bool files_equal(const char *first, const char *second)
+{
+        FILE *files[2] = {fopen(first, "rb"), fopen(second, "rb")};
+        _Bool equal = files[0] != NULL && files[1] != NULL;
+        int a = 0, b = 0;
+        while (equal && (a = fgetc(files[0])) == (b = fgetc(files[1])) && a != EOF)
+                ;
+        equal = equal && a == b;
+        for (unsigned f = 0; f < 2; f++)
+        {
+                if (files[f] != NULL)
+                        fclose(files[f]);
         }
+        return equal;
 }
@@ -0,0 +1,108 @@
+// Include Guards
+#ifndef MANDELBROT_H
+#define MANDELBROT_H
+#include <stddef.h>
+#include <stdint.h>
+
+// Methodendeklaration der Assembly Implementierung des Algorithmus (mandelbrot.S).
+// Schreibt wie bisher drei Byte Farbe pro Pixel nach img
+extern void mandelbrot(float r_start, float r_end, float i_start, float i_end, float resolution, unsigned char *img, int16_t max_iterations);
+
+// Methodendeklaration der Kachel-Variante der Assembly Implementierung (mandelbrot.S).
+// Berechnet die Pixel [x;x+width) x [y;y+height) des Gesamtbildes, dessen erstes Pixel
+// bei (r_start, i_start) liegt, und schreibt ihre Iterationszähler zeilenweise mit
+// einem Zeilenabstand von stride Pixeln ab counts. Punkte der Mandelbrotmenge
+// erhalten max_iterations. Die Breite muss ein Vielfaches von 4 sein
+extern void mandelbrot_tile(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                            uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Methodendeklaration der Referenzimplementierung des zu entwickelnden Algorithmus
+void mandelbrot_c(float r_start, float r_end, float i_start, float i_end, float resolution, unsigned char *img, int16_t max_iterations);
+
+// Methodendeklaration der Kachel-Variante der Referenzimplementierung mit derselben
+// Signatur wie mandelbrot_tile
+void mandelbrot_c_tile(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                       uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Methodendeklaration der Kachel-Variante der Referenzimplementierung mit doppelter
+// Genauigkeit für mittlere Zoomtiefen
+void mandelbrot_c_tile_double(double r_start, double i_start, double resolution, uint16_t *counts, int16_t max_iterations,
+                              uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Methodendeklarationen der Referenzimplementierung mit denselben FMA Rundungen wie
+// die AVX2 und AVX-512 Kernel, deren Zähler exakt mit ihr übereinstimmen
+void mandelbrot_c_tile_fma(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                           uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+void mandelbrot_c_tile_double_fma(double r_start, double i_start, double resolution, uint16_t *counts,
+                                  int16_t max_iterations, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+                                  size_t stride);
+
+// mandelbrot_c_color: Schreibt die Farbe eines Pixels mit der gegebenen Anzahl an
+// Iterationen als drei Byte an pixel. Punkte der Mandelbrotmenge werden schwarz.
+// Einzige Definition des ursprünglichen Farbschemas (s. palette.c)
+void mandelbrot_c_color(unsigned char *pixel, int16_t iterations, int16_t max_iterations);
+
+// mandelbrot_c_colorize: Wandelt die am Anfang von img stehenden Iterationszähler von
+// pixels Pixeln an Ort und Stelle in je drei Byte Farbe um
+void mandelbrot_c_colorize(unsigned char *img, uint64_t pixels, int16_t max_iterations);
+
+// mandelbrot_c_iterations: Gibt die Anzahl der Iterationen der Referenzimplementierung
+// für c = real + imaginary * i zurück. Punkte der Mandelbrotmenge ergeben max_iterations
+int16_t mandelbrot_c_iterations(float real, float imaginary, int16_t max_iterations);
+int16_t mandelbrot_c_iterations_double(double real, double imaginary, int16_t max_iterations);
+
+// mandelbrot_c_interior: Gibt zurück, ob c = real + imaginary * i in der Hauptkardioide
+// oder im Kreis der Periode 2 liegt und damit ohne Iteration zur Mandelbrotmenge gehört
+_Bool mandelbrot_c_interior(float real, float imaginary);
+_Bool mandelbrot_c_interior_double(double real, double imaginary);
+
+// Gemeinsamer Typ aller Kachel-Kernel
+typedef void (*tile_kernel)(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                            uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Gemeinsamer Typ aller Kachel-Kernel mit doppelter Genauigkeit
+typedef void (*tile_kernel_double)(double r_start, double i_start, double resolution, uint16_t *counts, int16_t max_iterations,
+                                   uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Methodendeklarationen der AVX2 (mandelbrot_avx2.S) und AVX-512 (mandelbrot_avx512.S)
+// Varianten von mandelbrot_tile mit 8 bzw. 16 Pixeln pro Iteration. Sie dürfen nur
+// aufgerufen werden, wenn der Prozessor die Befehlssätze unterstützt (s. kernel.h)
+extern void mandelbrot_tile_avx2(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                                 uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+extern void mandelbrot_tile_avx512(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                                   uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Methodendeklarationen der Varianten mit doppelter Genauigkeit (4 bzw. 8 Pixel pro Iteration)
+extern void mandelbrot_tile_double_avx2(double r_start, double i_start, double resolution, uint16_t *counts, int16_t max_iterations,
+                                        uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+extern void mandelbrot_tile_double_avx512(double r_start, double i_start, double resolution, uint16_t *counts, int16_t max_iterations,
+                                          uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+
+// Methodendeklarationen der AVX-512 Varianten, deren Vektorelemente sich die Pixel der
+// Kachel einzeln aus einer Warteschlange holen, statt in festen Gruppen zu rechnen
+extern void mandelbrot_tile_refill_avx512(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                                          uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+extern void mandelbrot_tile_double_refill_avx512(double r_start, double i_start, double resolution, uint16_t *counts,
+                                                 int16_t max_iterations, uint64_t x, uint64_t y, uint64_t width,
+                                                 uint64_t height, size_t stride);
+
+// Methodendeklarationen der AVX-512 Varianten, die zwei Gruppen verschränkt rechnen und
+// die Abbruchbedingung nur nach je 1, 4 oder 8 Iterationen prüfen. Die Zähler stimmen
+// mit denen von mandelbrot_tile_avx512 bzw. mandelbrot_tile_double_avx512 überein
+extern void mandelbrot_tile_unroll1_avx512(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                                           uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+extern void mandelbrot_tile_unroll4_avx512(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                                           uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+extern void mandelbrot_tile_unroll8_avx512(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                                           uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride);
+extern void mandelbrot_tile_double_unroll1_avx512(double r_start, double i_start, double resolution, uint16_t *counts,
+                                                  int16_t max_iterations, uint64_t x, uint64_t y, uint64_t width,
+                                                  uint64_t height, size_t stride);
+extern void mandelbrot_tile_double_unroll4_avx512(double r_start, double i_start, double resolution, uint16_t *counts,
+                                                  int16_t max_iterations, uint64_t x, uint64_t y, uint64_t width,
+                                                  uint64_t height, size_t stride);
+extern void mandelbrot_tile_double_unroll8_avx512(double r_start, double i_start, double resolution, uint16_t *counts,
+                                                  int16_t max_iterations, uint64_t x, uint64_t y, uint64_t width,
+                                                  uint64_t height, size_t stride);
+
+#endif // !MANDELBROT_H
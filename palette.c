@@ -0,0 +1,133 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mandelbrot.h"
+#include "palette.h"
+
+// Namen der Farbschemata in der Reihenfolge von palette_scheme
+static const char *const palette_names[] = {"classic", "gray"};
+
+// Die Farben werden als vier Byte gespeichert, damit jedes Pixel mit einem
+// einzigen Zugriff ohne Division oder Verzweigung nachgeschlagen werden kann. Für
+// die indizierten Formate wird zusätzlich jeder Iterationszahl der Index ihrer Farbe
+// in der Tabelle der verschiedenen Farben zugeordnet
+struct palette
+{
+        int16_t max_iterations;
+        unsigned table_count; // Anzahl der verschiedenen Farben, 0 falls mehr als 256
+        uint32_t table[256];  // Verschiedene Farben in der Reihenfolge ihres Auftretens
+        uint8_t *indices;     // Index in table zu jeder Iterationszahl, liegt hinter colors
+        uint32_t colors[];    // Farbe zu jeder Iterationszahl 0 bis max_iterations
+};
+
+_Bool palette_parse(const char *name, palette_scheme *scheme)
+{
+        for (unsigned i = 0; i < sizeof(palette_names) / sizeof(*palette_names); i++)
+        {
+                if (!strcmp(name, palette_names[i]))
+                {
+                        *scheme = (palette_scheme)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+const char *palette_name(palette_scheme scheme)
+{
+        return palette_names[scheme];
+}
+
+palette *palette_create(palette_scheme scheme, int16_t max_iterations, _Bool rgb)
+{
+        if (max_iterations < 0)
+                max_iterations = 0;
+        size_t entries = (size_t)max_iterations + 1;
+        palette *palette = malloc(sizeof(*palette) + entries * (sizeof(uint32_t) + sizeof(uint8_t)));
+        if (palette == NULL)
+                return NULL;
+        palette->max_iterations = max_iterations;
+        palette->table_count = 0;
+        palette->indices = (uint8_t *)(palette->colors + entries);
+
+        for (int32_t i = 0; i <= max_iterations; i++)
+        {
+                unsigned char pixel[4] = {0};
+                if (scheme == PALETTE_CLASSIC)
+                {
+                        mandelbrot_c_color(pixel, (int16_t)i, max_iterations);
+                }
+                else if (i != max_iterations)
+                {
+                        // Die Wurzel streckt die vielen Pixel mit wenigen Iterationen
+                        unsigned char value = (unsigned char)(255 * sqrt((double)i / max_iterations));
+                        pixel[0] = pixel[1] = pixel[2] = value;
+                }
+                if (rgb)
+                {
+                        unsigned char blue = pixel[0];
+                        pixel[0] = pixel[2];
+                        pixel[2] = blue;
+                }
+                memcpy(&palette->colors[i], pixel, sizeof(uint32_t));
+
+                // Die Schemata verwenden wenige Farben, eine lineare Suche genügt
+                unsigned index = 0;
+                while (index < palette->table_count && palette->table[index] != palette->colors[i])
+                        index++;
+                if (index == palette->table_count && palette->table_count <= 256)
+                {
+                        if (palette->table_count < 256)
+                                palette->table[index] = palette->colors[i];
+                        palette->table_count++;
+                }
+                palette->indices[i] = (uint8_t)index;
+        }
+        if (palette->table_count > 256)
+                palette->table_count = 0;
+        return palette;
+}
+
+// Je Pixel werden alle vier Byte der Tabelle geschrieben. Das vierte Byte wird vom
+// folgenden Pixel überschrieben, nur das letzte Pixel wird mit drei Byte geschrieben
+void palette_apply(const palette *palette, const uint16_t *counts, unsigned char *img, uint64_t pixels)
+{
+        if (pixels == 0)
+                return;
+
+        const uint32_t *colors = palette->colors;
+        for (uint64_t i = 0; i < pixels - 1; i++)
+                memcpy(img + i * 3, &colors[counts[i]], sizeof(uint32_t));
+        memcpy(img + (pixels - 1) * 3, &colors[counts[pixels - 1]], 3);
+}
+
+void palette_apply_rows(const palette *palette, const uint16_t *counts, size_t count_stride, unsigned char *rows,
+                        ptrdiff_t stride, uint64_t width, uint64_t count)
+{
+        for (uint64_t row = 0; row < count; row++)
+                palette_apply(palette, counts + row * count_stride, rows + (ptrdiff_t)row * stride, width);
+}
+
+const uint32_t *palette_colors(const palette *palette, unsigned *count)
+{
+        *count = palette->table_count;
+        return palette->table_count ? palette->table : NULL;
+}
+
+void palette_index_rows(const palette *palette, const uint16_t *counts, size_t count_stride, unsigned char *rows,
+                        ptrdiff_t stride, uint64_t width, uint64_t count)
+{
+        const uint8_t *indices = palette->indices;
+        for (uint64_t row = 0; row < count; row++)
+        {
+                const uint16_t *source = counts + row * count_stride;
+                unsigned char *target = rows + (ptrdiff_t)row * stride;
+                for (uint64_t x = 0; x < width; x++)
+                        target[x] = indices[source[x]];
+        }
+}
+
+void palette_destroy(palette *palette)
+{
+        free(palette);
+}
@@ -0,0 +1,55 @@
+// Include Guards
+#ifndef PALETTE_H
+#define PALETTE_H
+#include <stddef.h>
+#include <stdint.h>
+
+// Farbschemata zur Umwandlung der Iterationszähler in Farben. PALETTE_CLASSIC ist
+// das ursprüngliche Schema mit zehn sich wiederholenden Farben, PALETTE_GRAY ein
+// stufenloser Verlauf von dunkel (wenige Iterationen) nach hell
+typedef enum
+{
+        PALETTE_CLASSIC,
+        PALETTE_GRAY,
+        PALETTE_COUNT,
+} palette_scheme;
+
+// Undurchsichtiger Typ einer Farbtabelle (s. palette.c)
+typedef struct palette palette;
+
+// palette_parse: Übersetzt den Namen eines Farbschemas ("classic", "gray"). Gibt 0
+// zurück, falls der Name unbekannt ist
+_Bool palette_parse(const char *name, palette_scheme *scheme);
+
+// palette_name: Gibt den Namen eines Farbschemas zurück
+const char *palette_name(palette_scheme scheme);
+
+// palette_create: Berechnet die Farben aller Iterationszahlen von 0 bis
+// max_iterations vorab, je Pixel in der Reihenfolge Blau, Grün, Rot oder mit rgb in
+// der Reihenfolge Rot, Grün, Blau. Gibt NULL zurück, falls kein Speicher verfügbar ist
+palette *palette_create(palette_scheme scheme, int16_t max_iterations, _Bool rgb);
+
+// palette_apply: Schreibt die Farben von pixels Iterationszählern als je drei Byte
+// nach img. Die Zähler dürfen max_iterations der Tabelle nicht übersteigen
+void palette_apply(const palette *palette, const uint16_t *counts, unsigned char *img, uint64_t pixels);
+
+// palette_apply_rows: Färbt count Zeilen zu je width Iterationszählern ein. Die
+// Zähler der Zeile n beginnen bei counts + n * count_stride, ihre Pixel bei
+// rows + n * stride. Über das Ende einer Zeile hinaus wird nichts geschrieben
+void palette_apply_rows(const palette *palette, const uint16_t *counts, size_t count_stride, unsigned char *rows,
+                        ptrdiff_t stride, uint64_t width, uint64_t count);
+
+// palette_colors: Gibt die verschiedenen Farben der Tabelle für die indizierten
+// Formate als je vier Byte (Farbe wie bei palette_create, 0) zurück. Gibt NULL zurück,
+// falls das Schema mehr als 256 verschiedene Farben verwendet
+const uint32_t *palette_colors(const palette *palette, unsigned *count);
+
+// palette_index_rows: Wie palette_apply_rows, schreibt aber je Pixel ein Byte mit dem
+// Index seiner Farbe in der Tabelle von palette_colors
+void palette_index_rows(const palette *palette, const uint16_t *counts, size_t count_stride, unsigned char *rows,
+                        ptrdiff_t stride, uint64_t width, uint64_t count);
+
+// palette_destroy: Gibt eine Farbtabelle frei
+void palette_destroy(palette *palette);
+
+#endif // !PALETTE_H
@@ -0,0 +1,196 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include "mandelbrot.h"
+
+// mandelbrot_c: Referenzimplementierung des in Assembly zu implementierenden Algorithmus
+// zur Berechnung und Visualisierung der Mandelbrotmenge. Funktionsweise und Dokumentation
+// des Algorithmus ist der Dokumentation zu entnehmen.
+void mandelbrot_c(float r_start, float r_end, float i_start, float i_end, float resolution, unsigned char *img, int16_t max_iterations)
+{
+        uint64_t width = (r_end - r_start) / resolution;
+        width = width - (width % 4);
+        uint64_t height = (i_end - i_start) / resolution;
+        height = height - (height % 4);
+        mandelbrot_c_tile(r_start, i_start, resolution, (uint16_t *)img, max_iterations, 0, 0, width, height, (size_t)width);
+        mandelbrot_c_colorize(img, width * height, max_iterations);
+}
+
+// iterations_float: Anzahl der Iterationen, nach denen die Folge zu
+// c = real + imaginary * i den Kreis mit Radius 2 verlässt. Punkte der Mandelbrotmenge
+// ergeben max_iterations. Die Referenz iteriert bewusst ohne die Abkürzungen der
+// Kernel (Kardioide, Kreis der Periode 2, Zyklenerkennung), damit --verify diese prüft.
+// Mit fused wird der Imaginärteil wie in den AVX2 und AVX-512 Kerneln mit einer
+// einzigen Rundung als fmaf(2 * Re, Im, imaginary) berechnet
+static inline int16_t iterations_float(float real_progress, float imaginary_progress, int16_t max_iterations, _Bool fused)
+{
+        int16_t iteration_counter = 0;
+        float last_Re = 0;
+        float last_Im = 0;
+        while (iteration_counter < max_iterations)
+        {
+                float tmp_Re = last_Re;
+                float tmp_Im = last_Im;
+                last_Re = tmp_Re * tmp_Re - tmp_Im * tmp_Im + real_progress;
+                last_Im = fused ? fmaf(2 * tmp_Re, tmp_Im, imaginary_progress) : (2 * tmp_Re * tmp_Im) + imaginary_progress;
+                if (!((last_Re * last_Re + last_Im * last_Im) < 4))
+                        break;
+                iteration_counter++;
+        }
+        return iteration_counter;
+}
+
+// iterations_double: Wie iterations_float, jedoch mit doppelter Genauigkeit
+static inline int16_t iterations_double(double real_progress, double imaginary_progress, int16_t max_iterations, _Bool fused)
+{
+        int16_t iteration_counter = 0;
+        double last_Re = 0;
+        double last_Im = 0;
+        while (iteration_counter < max_iterations)
+        {
+                double tmp_Re = last_Re;
+                double tmp_Im = last_Im;
+                last_Re = tmp_Re * tmp_Re - tmp_Im * tmp_Im + real_progress;
+                last_Im = fused ? fma(2 * tmp_Re, tmp_Im, imaginary_progress) : (2 * tmp_Re * tmp_Im) + imaginary_progress;
+                if (!((last_Re * last_Re + last_Im * last_Im) < 4))
+                        break;
+                iteration_counter++;
+        }
+        return iteration_counter;
+}
+
+// tile_float: Berechnet die Zähler einer Kachel mit iterations_float. Die Koordinaten
+// eines Pixels werden wie in der Assembly Implementierung aus seinem Index im
+// Gesamtbild berechnet, der wie dort vorzeichenbehaftet umgerechnet wird
+static void tile_float(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                       uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride, _Bool fused)
+{
+        for (uint64_t row = 0; row < height; row++)
+        {
+                float imaginary_progress = i_start + (float)(int64_t)(y + row) * resolution;
+                uint16_t *count = counts + row * stride;
+                for (uint64_t column = 0; column < width; column++)
+                {
+                        float real_progress = r_start + (float)(int64_t)(x + column) * resolution;
+                        count[column] = iterations_float(real_progress, imaginary_progress, max_iterations, fused);
+                }
+        }
+}
+
+// tile_double: Wie tile_float, jedoch mit doppelter Genauigkeit
+static void tile_double(double r_start, double i_start, double resolution, uint16_t *counts, int16_t max_iterations,
+                        uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride, _Bool fused)
+{
+        for (uint64_t row = 0; row < height; row++)
+        {
+                double imaginary_progress = i_start + (double)(int64_t)(y + row) * resolution;
+                uint16_t *count = counts + row * stride;
+                for (uint64_t column = 0; column < width; column++)
+                {
+                        double real_progress = r_start + (double)(int64_t)(x + column) * resolution;
+                        count[column] = iterations_double(real_progress, imaginary_progress, max_iterations, fused);
+                }
+        }
+}
+
+// mandelbrot_c_tile: Referenzimplementierung von mandelbrot_tile
+void mandelbrot_c_tile(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                       uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride)
+{
+        tile_float(r_start, i_start, resolution, counts, max_iterations, x, y, width, height, stride, 0);
+}
+
+// mandelbrot_c_tile_double: Wie mandelbrot_c_tile, jedoch mit doppelter Genauigkeit
+void mandelbrot_c_tile_double(double r_start, double i_start, double resolution, uint16_t *counts, int16_t max_iterations,
+                              uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride)
+{
+        tile_double(r_start, i_start, resolution, counts, max_iterations, x, y, width, height, stride, 0);
+}
+
+// mandelbrot_c_tile_fma: Wie mandelbrot_c_tile mit den FMA Rundungen der AVX2 und
+// AVX-512 Kernel
+void mandelbrot_c_tile_fma(float r_start, float i_start, float resolution, uint16_t *counts, int16_t max_iterations,
+                           uint64_t x, uint64_t y, uint64_t width, uint64_t height, size_t stride)
+{
+        tile_float(r_start, i_start, resolution, counts, max_iterations, x, y, width, height, stride, 1);
+}
+
+// mandelbrot_c_tile_double_fma: Wie mandelbrot_c_tile_double mit den FMA Rundungen
+// der AVX2 und AVX-512 Kernel
+void mandelbrot_c_tile_double_fma(double r_start, double i_start, double resolution, uint16_t *counts,
+                                  int16_t max_iterations, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+                                  size_t stride)
+{
+        tile_double(r_start, i_start, resolution, counts, max_iterations, x, y, width, height, stride, 1);
+}
+
+// mandelbrot_c_iterations: Anzahl der Iterationen der Referenzimplementierung
+// (s. iterations_float)
+int16_t mandelbrot_c_iterations(float real_progress, float imaginary_progress, int16_t max_iterations)
+{
+        return iterations_float(real_progress, imaginary_progress, max_iterations, 0);
+}
+
+// mandelbrot_c_iterations_double: Wie mandelbrot_c_iterations, jedoch mit doppelter Genauigkeit
+int16_t mandelbrot_c_iterations_double(double real_progress, double imaginary_progress, int16_t max_iterations)
+{
+        return iterations_double(real_progress, imaginary_progress, max_iterations, 0);
+}
+
+// mandelbrot_c_interior: Prüft, ob c in der Hauptkardioide oder im Kreis der Periode 2
+// liegt. Die Rechenschritte entsprechen denen der Assembly Implementierungen. Wird nur
+// für die Messwerte und die Störungsrechnung genutzt, nicht von der Referenz selbst
+_Bool mandelbrot_c_interior(float real, float imaginary)
+{
+        float shifted = real - 0.25f;
+        float imaginary_squared = imaginary * imaginary;
+        float q = shifted * shifted + imaginary_squared;
+        if ((shifted + q) * q <= imaginary_squared * 0.25f)
+                return 1;
+        return (real + 1.0f) * (real + 1.0f) + imaginary_squared <= 0.0625f;
+}
+
+// mandelbrot_c_interior_double: Wie mandelbrot_c_interior mit doppelter Genauigkeit
+_Bool mandelbrot_c_interior_double(double real, double imaginary)
+{
+        double shifted = real - 0.25;
+        double imaginary_squared = imaginary * imaginary;
+        double q = shifted * shifted + imaginary_squared;
+        if ((shifted + q) * q <= imaginary_squared * 0.25)
+                return 1;
+        return (real + 1.0) * (real + 1.0) + imaginary_squared <= 0.0625;
+}
+
+// mandelbrot_c_color: Farbgebung der Referenzimplementierung. Punkte, die die
+// maximale Anzahl an Iterationen erreicht haben, gehören zur Mandelbrotmenge
+void mandelbrot_c_color(unsigned char *pixel, int16_t iterations, int16_t max_iterations)
+{
+        static const u_int8_t colorscheme[36] = {205, 116, 24, 238, 134, 28, 255, 144, 30, 34, 180, 238, 37, 193, 255, 0, 215, 255, 0, 102, 205, 0, 118, 238, 0, 127, 255, 44, 44, 238};
+        if (iterations != max_iterations)
+        {
+                u_int8_t color = (iterations % max_iterations) % 10;
+                pixel[0] = colorscheme[3 * (color) + 0];
+                pixel[1] = colorscheme[3 * (color) + 1];
+                pixel[2] = colorscheme[3 * (color) + 2];
+        }
+        else
+        {
+                pixel[0] = 0;
+                pixel[1] = 0;
+                pixel[2] = 0;
+        }
+}
+
+// mandelbrot_c_colorize: Wandelt von hinten nach vorne um. Die Farbe des Pixels i
+// belegt die Byte [3i;3i+3) und überschreibt damit nur bereits gelesene Zähler der
+// Pixel i bis 3i/2 + 1
+void mandelbrot_c_colorize(unsigned char *img, uint64_t pixels, int16_t max_iterations)
+{
+        for (uint64_t i = pixels; i-- > 0;)
+        {
+                uint16_t iterations;
+                memcpy(&iterations, img + i * 2, sizeof(iterations));
+                mandelbrot_c_color(img + i * 3, (int16_t)iterations, max_iterations);
+        }
+}
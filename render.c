@@ -0,0 +1,1046 @@
+#include <math.h>
+#include <quadmath.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "render.h"
+
+// Namen der Genauigkeitsstufen in der Reihenfolge von precision_tier
+static const char *const precision_names[] = {"auto", "float", "double", "perturbation"};
+
+// Namen der Modi in der Reihenfolge von render_mode
+static const char *const render_mode_names[] = {"scan", "subdivide"};
+
+// Namen der Überprüfungen in der Reihenfolge von verify_mode
+static const char *const verify_mode_names[] = {"off", "full", "sampled"};
+
+// Rechtecke, die niedriger als das Doppelte dieses Wertes sind, werden beim
+// Unterteilen nicht weiter geteilt, sondern vollständig berechnet
+#define SUBDIVIDE_MIN_SIZE 16
+
+struct render_plan
+{
+        precision_tier precision;
+        render_view view;
+
+        // PRECISION_FLOAT
+        tile_kernel kernel;
+        float r_start;
+        float i_start;
+        float resolution;
+
+        // PRECISION_DOUBLE
+        tile_kernel_double kernel_double;
+        double r_start_double;
+        double i_start_double;
+
+        // PRECISION_PERTURBATION: Orbit des Pixels (ref_x, ref_y)
+        reference_orbit *orbit;
+        double ref_x;
+        double ref_y;
+
+        // Anzahl der gleichzeitig berechneten Pixel des Kernels
+        uint64_t lanes;
+
+        // Index des Pixels (0, 0) im Raster der Kernelkoordinaten. Ungleich 0 für Pläne,
+        // die auf die reelle Achse oder das Raster eines anderen Ausschnitts ausgerichtet
+        // sind (s. render_plan_create und render_plan_align). Die Kernel rechnen die
+        // Indizes vorzeichenbehaftet um
+        int64_t grid_x;
+        int64_t grid_y;
+
+        // Zeilen y und mirror_axis - y haben exakt entgegengesetzte Imaginärteile (0: keine)
+        uint64_t mirror_axis;
+
+        // Kernel mit FMA Befehlen, deren Zähler von denen der übrigen abweichen können
+        _Bool fma;
+
+        // Messwerte aller Kernelaufrufe (NULL: keine Erfassung)
+        render_stats *stats;
+};
+
+// Kontext eines parallelen Durchlaufs, der an alle Kachelaufgaben übergeben wird
+struct render_job
+{
+        const render_plan *plan;
+        uint16_t *counts;
+        size_t stride;
+        uint64_t y;
+        uint64_t height;
+        uint64_t tile_size;
+        uint64_t columns;
+        render_mode mode;
+        const size_t *tiles; // Indizes der zu berechnenden Kacheln (NULL: alle)
+
+        // Zeilendurchläufe des progressiven Modus: Zeilen first_row, first_row + row_step
+        // usw., jeweils in columns Abschnitte zu tile_size Pixeln geteilt
+        uint64_t first_row;
+        uint64_t row_step;
+};
+
+// Abstand der berechneten Pixel des ersten progressiven Durchlaufs
+#define PROGRESSIVE_STEP 8
+
+// Erste Zeile und Zeilenabstand der Zeilendurchläufe 1 bis RENDER_PASSES - 1 sowie
+// der Abstand der danach berechneten Zeilen
+static const uint64_t pass_rows[RENDER_PASSES][3] = {{0, 0, 0}, {0, 8, 8}, {4, 8, 4}, {2, 4, 2}, {1, 2, 1}};
+
+_Bool precision_parse(const char *name, precision_tier *precision)
+{
+        for (unsigned i = 0; i < sizeof(precision_names) / sizeof(*precision_names); i++)
+        {
+                if (!strcmp(name, precision_names[i]))
+                {
+                        *precision = (precision_tier)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+const char *precision_name(precision_tier precision)
+{
+        return precision_names[precision];
+}
+
+_Bool render_mode_parse(const char *name, render_mode *mode)
+{
+        for (unsigned i = 0; i < sizeof(render_mode_names) / sizeof(*render_mode_names); i++)
+        {
+                if (!strcmp(name, render_mode_names[i]))
+                {
+                        *mode = (render_mode)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+const char *render_mode_name(render_mode mode)
+{
+        return render_mode_names[mode];
+}
+
+_Bool verify_mode_parse(const char *name, verify_mode *verify)
+{
+        for (unsigned i = 0; i < sizeof(verify_mode_names) / sizeof(*verify_mode_names); i++)
+        {
+                if (!strcmp(name, verify_mode_names[i]))
+                {
+                        *verify = (verify_mode)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+const char *verify_mode_name(verify_mode verify)
+{
+        return verify_mode_names[verify];
+}
+
+// Eine Stufe reicht aus, wenn zwei benachbarte Pixel beim betragsgrößten
+// Koordinatenwert noch mindestens 2^8 Einheiten der letzten Stelle
+// auseinanderliegen (float: 24, double: 53 Bit Mantisse). Der Rest dient als
+// Reserve für die Rundungsfehler während der Iteration
+precision_tier precision_resolve(precision_tier precision, hp_float r_start, hp_float r_end,
+                                 hp_float i_start, hp_float i_end, double resolution)
+{
+        if (precision != PRECISION_AUTO)
+                return precision;
+
+        double magnitude = 1;
+        hp_float bounds[] = {r_start, r_end, i_start, i_end};
+        for (unsigned i = 0; i < 4; i++)
+        {
+                double value = (double)(bounds[i] < 0 ? -bounds[i] : bounds[i]);
+                if (value > magnitude)
+                        magnitude = value;
+        }
+
+        double ratio = resolution / magnitude;
+        if (ratio >= 0x1p-16)
+                return PRECISION_FLOAT;
+        if (ratio >= 0x1p-45)
+                return PRECISION_DOUBLE;
+        return PRECISION_PERTURBATION;
+}
+
+uint64_t render_dimension(hp_float start, hp_float end, double resolution, precision_tier precision)
+{
+        hp_float size;
+        if (precision == PRECISION_FLOAT)
+                size = ((float)end - (float)start) / (float)resolution;
+        else
+                size = (end - start) / resolution;
+
+        if (!(size > 0) || size >= 0x1p63)
+                return 0;
+        uint64_t dimension = (uint64_t)size;
+        return dimension - (dimension % 4);
+}
+
+// job_count: Pointer auf den Iterationszähler in Spalte x und Zeile row des Streifens
+static uint16_t *job_count(const struct render_job *job, uint64_t x, uint64_t row)
+{
+        return job->counts + row * job->stride + x;
+}
+
+// stats_now: Monotone Zeit in Nanosekunden
+static uint64_t stats_now(void)
+{
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_nsec;
+}
+
+// pixel_interior: Prüft mit den Koordinaten des Kernels, ob das Pixel (x, y) in der
+// Hauptkardioide oder im Kreis der Periode 2 liegt und daher nicht iteriert wurde
+static _Bool pixel_interior(const render_plan *plan, uint64_t x, uint64_t y)
+{
+        switch (plan->precision)
+        {
+        case PRECISION_PERTURBATION:
+                return plan->orbit->length > 0 &&
+                       mandelbrot_c_interior_double(plan->orbit->re[1] + ((double)x - plan->ref_x) * plan->view.resolution,
+                                                    plan->orbit->im[1] + ((double)y - plan->ref_y) * plan->view.resolution);
+        case PRECISION_DOUBLE:
+                return mandelbrot_c_interior_double(
+                    plan->r_start_double + (double)(plan->grid_x + (int64_t)x) * plan->view.resolution,
+                    plan->i_start_double + (double)(plan->grid_y + (int64_t)y) * plan->view.resolution);
+        default:
+                return mandelbrot_c_interior(plan->r_start + (float)(plan->grid_x + (int64_t)x) * plan->resolution,
+                                             plan->i_start + (float)(plan->grid_y + (int64_t)y) * plan->resolution);
+        }
+}
+
+// stats_record: Erfasst den Kernelaufruf für das Rechteck [x;x+width) x [y;y+height)
+// des Plans, dessen Zähler ab counts stehen, und verteilt seine Dauer duration nach der
+// Fläche auf die überdeckten Zellen der Zeitkarte. Rechtecke abgeleiteter Pläne mit
+// anderer Bildgröße werden dazu auf das Bild umgerechnet
+static void stats_record(const render_plan *plan, const uint16_t *counts, size_t stride, uint64_t x, uint64_t y,
+                         uint64_t width, uint64_t height, uint64_t duration)
+{
+        render_stats *stats = plan->stats;
+        const render_view *view = &plan->view;
+        uint64_t iterations = 0;
+        uint64_t lane_iterations = 0;
+        for (uint64_t row = 0; row < height; row++)
+        {
+                const uint16_t *line = counts + row * stride;
+                for (uint64_t group = 0; group < width; group += plan->lanes)
+                {
+                        uint64_t slowest = 0;
+                        for (uint64_t i = group; i < group + plan->lanes && i < width; i++)
+                        {
+                                uint64_t work = line[i];
+                                if (line[i] == view->max_iterations && pixel_interior(plan, x + i, y + row))
+                                        work = 0;
+                                iterations += work;
+                                slowest = work > slowest ? work : slowest;
+                        }
+                        lane_iterations += slowest * plan->lanes;
+                }
+        }
+        __atomic_fetch_add(&stats->calls, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats->pixels, width * height, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats->iterations, iterations, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats->lane_iterations, lane_iterations, __ATOMIC_RELAXED);
+
+        double scale_x = (double)stats->width / (double)view->width;
+        double scale_y = (double)stats->height / (double)view->height;
+        double left = (double)x * scale_x;
+        double right = (double)(x + width) * scale_x;
+        double bottom = (double)y * scale_y;
+        double top = (double)(y + height) * scale_y;
+        double area = (right - left) * (top - bottom);
+        double cell = (double)stats->cell_size;
+        for (uint64_t row = (uint64_t)(bottom / cell); row < stats->rows && row * cell < top; row++)
+        {
+                double overlap_y = fmin(top, (row + 1) * cell) - fmax(bottom, row * cell);
+                for (uint64_t column = (uint64_t)(left / cell); column < stats->columns && column * cell < right; column++)
+                {
+                        double overlap_x = fmin(right, (column + 1) * cell) - fmax(left, column * cell);
+                        __atomic_fetch_add(&stats->cell_time[row * stats->columns + column],
+                                           (uint64_t)(duration * overlap_x * overlap_y / area + 0.5), __ATOMIC_RELAXED);
+                }
+        }
+}
+
+// render_rect: Ruft den Kernel für das Rechteck [x;x+width) x [row;row+height) des
+// Streifens auf. Die Breite muss ein Vielfaches von 4 sein
+static void render_rect(const struct render_job *job, uint64_t x, uint64_t row, uint64_t width, uint64_t height)
+{
+        const render_plan *plan = job->plan;
+        const render_view *view = &plan->view;
+        uint64_t y = job->y + row;
+        uint16_t *counts = job_count(job, x, row);
+        uint64_t start = plan->stats != NULL ? stats_now() : 0;
+
+        switch (plan->precision)
+        {
+        case PRECISION_PERTURBATION:
+                mandelbrot_perturbation_tile(plan->orbit, plan->ref_x, plan->ref_y, view->resolution, counts,
+                                             view->max_iterations, x, y, width, height, job->stride);
+                break;
+        case PRECISION_DOUBLE:
+                plan->kernel_double(plan->r_start_double, plan->i_start_double, view->resolution, counts,
+                                    view->max_iterations, (uint64_t)plan->grid_x + x, (uint64_t)plan->grid_y + y, width, height,
+                                    job->stride);
+                break;
+        default:
+                plan->kernel(plan->r_start, plan->i_start, plan->resolution, counts,
+                             view->max_iterations, (uint64_t)plan->grid_x + x, (uint64_t)plan->grid_y + y, width, height,
+                             job->stride);
+                break;
+        }
+
+        if (plan->stats != NULL)
+                stats_record(plan, counts, job->stride, x, y, width, height, stats_now() - start);
+}
+
+// border_uniform: Prüft, ob alle berechneten Randpixel eines Rechtecks denselben
+// Iterationszähler haben. Der Rand besteht aus der ersten und letzten Zeile sowie den jeweils
+// block Pixel breiten Spaltengruppen am linken und rechten Rand
+static _Bool border_uniform(const struct render_job *job, uint64_t x, uint64_t row, uint64_t width, uint64_t height,
+                            uint64_t block)
+{
+        uint16_t count = *job_count(job, x, row);
+        for (uint64_t r = row; r < row + height; r++)
+        {
+                const uint16_t *line = job_count(job, x, r);
+                _Bool edge = r == row || r == row + height - 1;
+                for (uint64_t i = 0; i < width; i++)
+                {
+                        if (!edge && i == block)
+                                i = width - block;
+                        if (line[i] != count)
+                                return 0;
+                }
+        }
+        return 1;
+}
+
+// rect_inside: Prüft, ob alle Pixel des bereits berechneten Rechtecks [x;x+width) x
+// [row;row+height) max_iterations erreicht haben
+static _Bool rect_inside(const struct render_job *job, uint64_t x, uint64_t row, uint64_t width, uint64_t height)
+{
+        uint16_t max_iterations = (uint16_t)job->plan->view.max_iterations;
+        for (uint64_t r = row; r < row + height; r++)
+        {
+                const uint16_t *line = job_count(job, x, r);
+                for (uint64_t i = 0; i < width; i++)
+                {
+                        if (line[i] != max_iterations)
+                                return 0;
+                }
+        }
+        return 1;
+}
+
+// subdivide: Berechnet das Innere eines Rechtecks, dessen Rand (s. border_uniform)
+// bereits berechnet ist. Das Rechteck wird durch eine berechnete Spaltengruppe und
+// Zeile geviertelt. Diese bilden die fehlenden Ränder der vier Teilrechtecke. Die
+// Spaltengruppen sind so breit wie die Vektoren des Kernels, damit keine
+// Vektorelemente ungenutzt bleiben. Gefüllt wird nur, wenn Rand und Kreuz vollständig
+// in der Menge liegen (max_iterations) und auch die beiden inneren Zeilen am oberen
+// und unteren Rand dies bestätigen. Die Menge hat zwar keine Löcher, doch Kanäle
+// des Äußeren können schmaler als ein Pixel zwischen den Randpixeln hindurchlaufen und
+// sich dahinter verbreitern. Einheitliche Ränder mit kleinerem Zähler werden nie
+// gefüllt, da sie dünne Filamente der Menge umschließen können
+static void subdivide(const struct render_job *job, uint64_t x, uint64_t row, uint64_t width, uint64_t height,
+                      uint64_t block)
+{
+        if (width <= 2 * block || height <= 2)
+                return;
+
+        if (width < 4 * block || height < 2 * SUBDIVIDE_MIN_SIZE)
+        {
+                render_rect(job, x + block, row + 1, width - 2 * block, height - 2);
+                return;
+        }
+
+        uint16_t max_iterations = (uint16_t)job->plan->view.max_iterations;
+        _Bool inside = *job_count(job, x, row) == max_iterations && border_uniform(job, x, row, width, height, block);
+        uint64_t middle_x = x + width / block / 2 * block;
+        uint64_t middle_row = row + height / 2;
+        render_rect(job, middle_x, row + 1, block, height - 2);
+        render_rect(job, x + block, middle_row, width - 2 * block, 1);
+        inside = inside && rect_inside(job, middle_x, row + 1, block, height - 2) &&
+                 rect_inside(job, x + block, middle_row, width - 2 * block, 1);
+        if (inside)
+        {
+                render_rect(job, x + block, row + 1, width - 2 * block, 1);
+                render_rect(job, x + block, row + height - 2, width - 2 * block, 1);
+                inside = rect_inside(job, x + block, row + 1, width - 2 * block, 1) &&
+                         rect_inside(job, x + block, row + height - 2, width - 2 * block, 1);
+        }
+        if (inside)
+        {
+                for (uint64_t r = row + 2; r < row + height - 2; r++)
+                {
+                        uint16_t *line = job_count(job, x + block, r);
+                        for (uint64_t i = 0; i < width - 2 * block; i++)
+                                line[i] = max_iterations;
+                }
+                return;
+        }
+
+        subdivide(job, x, row, middle_x + block - x, middle_row + 1 - row, block);
+        subdivide(job, middle_x, row, x + width - middle_x, middle_row + 1 - row, block);
+        subdivide(job, x, middle_row, middle_x + block - x, row + height - middle_row, block);
+        subdivide(job, middle_x, middle_row, x + width - middle_x, row + height - middle_row, block);
+}
+
+// tile_bounds: Berechnet aus dem Index die Lage der Kachel im Streifen. Randkacheln
+// werden passend gekürzt
+static void tile_bounds(const struct render_job *job, size_t index, uint64_t *x, uint64_t *row,
+                        uint64_t *width, uint64_t *height)
+{
+        uint64_t image_width = job->plan->view.width;
+        *x = (index % job->columns) * job->tile_size;
+        *row = (index / job->columns) * job->tile_size;
+        *width = image_width - *x < job->tile_size ? image_width - *x : job->tile_size;
+        *height = job->height - *row < job->tile_size ? job->height - *row : job->tile_size;
+}
+
+// tile_key_of: Schlüssel der Kachel im Cache. Die Lage ihres ersten Pixels wird in
+// Vielfachen der Resolution angegeben und auf 1/1024 Pixel gerundet. So treffen auch
+// um ganze Kacheln verschobene Ausschnitte, deren Ursprung sich nur durch
+// Rundungsfehler der Eingabe unterscheidet, dieselben Kacheln
+static tile_key tile_key_of(const struct render_job *job, uint64_t x, uint64_t row, uint64_t width, uint64_t height)
+{
+        const render_view *view = &job->plan->view;
+        hp_float r = view->r_start / view->resolution + (hp_float)x;
+        hp_float i = view->i_start / view->resolution + (hp_float)(job->y + row);
+        return (tile_key){
+            .r = roundq(r * 1024) / 1024,
+            .i = roundq(i * 1024) / 1024,
+            .resolution = view->resolution,
+            .max_iterations = view->max_iterations,
+            .precision = (uint8_t)job->plan->precision,
+            .fma = job->plan->fma,
+            .mode = (uint8_t)job->mode,
+            .width = (uint32_t)width,
+            .height = (uint32_t)height,
+        };
+}
+
+// render_tile: Aufgabe des Threadpools. Berechnet die Kachel entweder vollständig
+// oder durch Unterteilung
+static void render_tile(void *ctx, size_t index, unsigned worker)
+{
+        (void)worker;
+        struct render_job *job = ctx;
+        uint64_t block = job->plan->lanes;
+
+        uint64_t x, row, width, height;
+        tile_bounds(job, job->tiles != NULL ? job->tiles[index] : index, &x, &row, &width, &height);
+
+        // Ohne Inneres lohnt sich die Unterteilung nicht. Die rechte Spaltengruppe
+        // einer am Bildrand gekürzten Kachel kann schmaler als ein Vektor sein
+        if (job->mode != RENDER_MODE_SUBDIVIDE || width % block || width <= 2 * block || height <= 2)
+        {
+                render_rect(job, x, row, width, height);
+                return;
+        }
+
+        render_rect(job, x, row, width, 1);
+        render_rect(job, x, row + height - 1, width, 1);
+        render_rect(job, x, row + 1, block, height - 2);
+        render_rect(job, x + width - block, row + 1, block, height - 2);
+        subdivide(job, x, row, width, height, block);
+}
+
+render_plan *render_plan_create(const render_view *view, kernel_variant kernel, lane_mode lanes, precision_tier precision)
+{
+        render_plan *plan = malloc(sizeof(*plan));
+        if (plan == NULL)
+                return NULL;
+        *plan = (render_plan){
+            .precision = precision,
+            .view = *view,
+            .kernel = kernel_get(kernel, lanes, view->max_iterations),
+            .r_start = (float)view->r_start,
+            .i_start = (float)view->i_start,
+            .resolution = (float)view->resolution,
+            .kernel_double = kernel_get_double(kernel, lanes, view->max_iterations),
+            .r_start_double = (double)view->r_start,
+            .i_start_double = (double)view->i_start,
+            .lanes = precision == PRECISION_PERTURBATION ? 4 : kernel_lanes(kernel, precision == PRECISION_DOUBLE),
+            .fma = precision != PRECISION_PERTURBATION && kernel_uses_fma(kernel),
+        };
+
+        // Liegt die reelle Achse bis auf 1/1024 Pixel genau auf der Zeile m des Bildes,
+        // rechnen die Kernel die Imaginärteile relativ zu ihr als (y - m) * resolution.
+        // Da die Rundung symmetrisch ist, erhalten die Zeilen m - k und m + k so exakt
+        // entgegengesetzte Imaginärteile. Die Iteration ist unter Vorzeichenwechsel des
+        // Imaginärteils exakt symmetrisch, da Rundung und Fluchtbedingung nur von Beträgen
+        // und Quadraten abhängen, sodass beide Zeilen dieselben Zähler haben
+        double row = (double)(-view->i_start / view->resolution);
+        if (precision != PRECISION_PERTURBATION && row >= 0 && row < (double)view->height &&
+            fabs(row - round(row)) < 0x1p-10)
+        {
+                plan->i_start = 0;
+                plan->i_start_double = 0;
+                plan->grid_y = -(int64_t)round(row);
+                plan->mirror_axis = 2 * (uint64_t)round(row);
+        }
+
+        // Der Referenzpunkt liegt in der Bildmitte, damit die Abweichungen der
+        // Pixel möglichst klein bleiben. Seine Koordinaten werden mit vierfacher
+        // Genauigkeit aus dem Ursprung des Bildes berechnet
+        if (precision == PRECISION_PERTURBATION)
+        {
+                plan->ref_x = (double)(view->width / 2);
+                plan->ref_y = (double)(view->height / 2);
+                plan->orbit = reference_orbit_create(view->r_start + (hp_float)plan->ref_x * view->resolution,
+                                                     view->i_start + (hp_float)plan->ref_y * view->resolution,
+                                                     view->max_iterations);
+                if (plan->orbit == NULL)
+                {
+                        free(plan);
+                        return NULL;
+                }
+        }
+        return plan;
+}
+
+render_plan *render_plan_create_reference(const render_view *view, precision_tier precision, _Bool fma)
+{
+        render_plan *plan = render_plan_create(view, KERNEL_C, LANES_GROUP, precision);
+        if (plan != NULL && fma)
+        {
+                plan->kernel = mandelbrot_c_tile_fma;
+                plan->kernel_double = mandelbrot_c_tile_double_fma;
+                plan->fma = precision != PRECISION_PERTURBATION;
+        }
+        return plan;
+}
+
+void render_plan_rows(threadpool *pool, const render_plan *plan, tile_cache *cache, uint16_t *counts, size_t stride,
+                      uint64_t y, uint64_t height, uint64_t tile_size, render_mode mode)
+{
+        struct render_job job = {
+            .plan = plan,
+            .counts = counts,
+            .stride = stride,
+            .y = y,
+            .height = height,
+            .tile_size = tile_size,
+            .columns = (plan->view.width + tile_size - 1) / tile_size,
+            .mode = mode,
+        };
+        uint64_t rows = (height + tile_size - 1) / tile_size;
+        size_t count = job.columns * rows;
+
+        // Mit Cache werden die vorhandenen Kacheln kopiert und nur die übrigen
+        // berechnet und anschließend abgelegt. Der Cache wird nur von diesem
+        // Thread verwendet
+        size_t *missing = cache != NULL ? malloc(count * sizeof(*missing)) : NULL;
+        if (missing == NULL)
+        {
+                threadpool_run(pool, count, render_tile, &job);
+                return;
+        }
+
+        size_t misses = 0;
+        uint64_t x, row, width, tile_height;
+        for (size_t index = 0; index < count; index++)
+        {
+                tile_bounds(&job, index, &x, &row, &width, &tile_height);
+                tile_key key = tile_key_of(&job, x, row, width, tile_height);
+                if (!tile_cache_get(cache, &key, job_count(&job, x, row), stride))
+                        missing[misses++] = index;
+        }
+
+        job.tiles = missing;
+        threadpool_run(pool, misses, render_tile, &job);
+
+        for (size_t i = 0; i < misses; i++)
+        {
+                tile_bounds(&job, missing[i], &x, &row, &width, &tile_height);
+                tile_key key = tile_key_of(&job, x, row, width, tile_height);
+                tile_cache_put(cache, &key, job_count(&job, x, row), stride);
+        }
+        free(missing);
+}
+
+_Bool render_plan_align(render_plan *plan, const render_view *grid)
+{
+        const render_view *view = &plan->view;
+        if (plan->precision == PRECISION_PERTURBATION || view->resolution != grid->resolution)
+                return 0;
+        double offset_x = (double)((view->r_start - grid->r_start) / grid->resolution);
+        double offset_y = (double)((view->i_start - grid->i_start) / grid->resolution);
+        if (offset_x < -0x1p-10 || offset_y < -0x1p-10 || fabs(offset_x - round(offset_x)) >= 0x1p-10 ||
+            fabs(offset_y - round(offset_y)) >= 0x1p-10)
+                return 0;
+
+        plan->r_start = (float)grid->r_start;
+        plan->i_start = (float)grid->i_start;
+        plan->r_start_double = (double)grid->r_start;
+        plan->i_start_double = (double)grid->i_start;
+        plan->grid_x = (int64_t)round(offset_x);
+        plan->grid_y = (int64_t)round(offset_y);
+        plan->mirror_axis = 0;
+        return 1;
+}
+
+uint64_t render_plan_mirror_axis(const render_plan *plan)
+{
+        // Mindestens die Zeilen 0 und 1 bzw. height - 2 und height - 1 müssen ein Paar bilden
+        uint64_t axis = plan->mirror_axis;
+        return axis >= 2 && axis <= 2 * plan->view.height - 4 ? axis : 0;
+}
+
+// copy_tile: Kopiert die Zähler der Kachel [x;x+width) x [y;y+height) aus dem vorherigen
+// Bild, in dem das Pixel (x, y) an der Stelle (x + shift_x, y + shift_y) liegt. Gibt 0
+// zurück, falls die Kachel nicht vollständig darin liegt
+static _Bool copy_tile(const render_view *old, const uint16_t *previous, uint16_t *counts, size_t stride,
+                       int64_t shift_x, int64_t shift_y, uint64_t x, uint64_t y, uint64_t width, uint64_t height)
+{
+        int64_t left = (int64_t)x + shift_x;
+        int64_t bottom = (int64_t)y + shift_y;
+        if (left < 0 || bottom < 0 || (uint64_t)left + width > old->width || (uint64_t)bottom + height > old->height)
+                return 0;
+        const uint16_t *source = previous + (uint64_t)bottom * old->width + (uint64_t)left;
+        for (uint64_t row = 0; row < height; row++)
+                memcpy(counts + row * stride, source + row * old->width, width * sizeof(uint16_t));
+        return 1;
+}
+
+// fill_tile: Füllt die Kachel [x;x+width) x [y;y+height), falls der von ihr überdeckte
+// Bereich des vorherigen Bildes samt einem Pixel Rand einheitlich ist. Die Lage des
+// Pixels (x, y) im vorherigen Bild ist (offset_x + x * scale, offset_y + y * scale). Wie
+// beim Unterteilen wird angenommen, dass keine Filamente zwischen den Pixeln hindurchlaufen.
+// Das trifft beim Zoomen oft nicht zu, da das neue Bild Details auflöst, die das gröbere
+// vorherige nicht enthielt. Gibt 0 zurück, falls die Kachel berechnet werden muss
+static _Bool fill_tile(const render_view *old, const uint16_t *previous, uint16_t *counts, size_t stride,
+                       double offset_x, double offset_y, double scale, uint64_t x, uint64_t y,
+                       uint64_t width, uint64_t height)
+{
+        double left = floor(offset_x + (double)x * scale) - 1;
+        double right = ceil(offset_x + (double)(x + width - 1) * scale) + 1;
+        double bottom = floor(offset_y + (double)y * scale) - 1;
+        double top = ceil(offset_y + (double)(y + height - 1) * scale) + 1;
+        if (left < 0 || bottom < 0 || right >= (double)old->width || top >= (double)old->height)
+                return 0;
+
+        uint16_t count = previous[(uint64_t)bottom * old->width + (uint64_t)left];
+        for (uint64_t row = (uint64_t)bottom; row <= (uint64_t)top; row++)
+        {
+                const uint16_t *line = previous + row * old->width;
+                for (uint64_t i = (uint64_t)left; i <= (uint64_t)right; i++)
+                {
+                        if (line[i] != count)
+                                return 0;
+                }
+        }
+        for (uint64_t row = 0; row < height; row++)
+        {
+                uint16_t *line = counts + row * stride;
+                for (uint64_t i = 0; i < width; i++)
+                        line[i] = count;
+        }
+        return 1;
+}
+
+uint64_t render_plan_reuse(threadpool *pool, const render_plan *plan, const render_plan *previous,
+                           const uint16_t *previous_counts, uint16_t *counts, uint64_t tile_size, render_mode mode,
+                           _Bool fill)
+{
+        const render_view *view = &plan->view;
+        struct render_job job = {
+            .plan = plan,
+            .counts = counts,
+            .stride = view->width,
+            .y = 0,
+            .height = view->height,
+            .tile_size = tile_size,
+            .columns = (view->width + tile_size - 1) / tile_size,
+            .mode = mode,
+        };
+        size_t count = job.columns * ((view->height + tile_size - 1) / tile_size);
+        size_t *missing = previous != NULL ? malloc(count * sizeof(*missing)) : NULL;
+        if (missing == NULL)
+        {
+                threadpool_run(pool, count, render_tile, &job);
+                return 0;
+        }
+
+        // Pläne auf demselben Raster berechnen gemeinsame Pixel mit denselben
+        // Koordinaten und demselben Kernel. Ihre Zähler werden daher exakt kopiert
+        const render_view *old = &previous->view;
+        _Bool aligned = plan->precision != PRECISION_PERTURBATION && plan->precision == previous->precision &&
+                        plan->kernel == previous->kernel && plan->kernel_double == previous->kernel_double &&
+                        view->max_iterations == old->max_iterations && view->resolution == old->resolution &&
+                        plan->resolution == previous->resolution && plan->r_start == previous->r_start &&
+                        plan->i_start == previous->i_start && plan->r_start_double == previous->r_start_double &&
+                        plan->i_start_double == previous->i_start_double;
+        int64_t shift_x = (int64_t)plan->grid_x - (int64_t)previous->grid_x;
+        int64_t shift_y = (int64_t)plan->grid_y - (int64_t)previous->grid_y;
+
+        // Lage des Bildes in Pixeln des vorherigen Bildes
+        double scale = view->resolution / old->resolution;
+        double offset_x = (double)((view->r_start - old->r_start) / old->resolution);
+        double offset_y = (double)((view->i_start - old->i_start) / old->resolution);
+
+        size_t misses = 0;
+        uint64_t x, row, width, height;
+        for (size_t index = 0; index < count; index++)
+        {
+                tile_bounds(&job, index, &x, &row, &width, &height);
+                uint16_t *tile = job_count(&job, x, row);
+                _Bool reused = aligned ? copy_tile(old, previous_counts, tile, job.stride, shift_x, shift_y, x, row, width, height)
+                                       : fill && fill_tile(old, previous_counts, tile, job.stride, offset_x, offset_y, scale,
+                                                           x, row, width, height);
+                if (!reused)
+                        missing[misses++] = index;
+        }
+
+        job.tiles = missing;
+        threadpool_run(pool, misses, render_tile, &job);
+        free(missing);
+        return count - misses;
+}
+
+// render_row: Aufgabe des Threadpools in den Zeilendurchläufen. Berechnet einen
+// Abschnitt einer Zeile
+static void render_row(void *ctx, size_t index, unsigned worker)
+{
+        (void)worker;
+        struct render_job *job = ctx;
+        uint64_t row = job->first_row + (index / job->columns) * job->row_step;
+        uint64_t x = (index % job->columns) * job->tile_size;
+        uint64_t width = job->plan->view.width - x < job->tile_size ? job->plan->view.width - x : job->tile_size;
+        render_rect(job, x, row, width, 1);
+}
+
+// render_coarse: Erster progressiver Durchlauf. Berechnet jedes achte Pixel jeder
+// achten Zeile als eigenes Bild mit achtfacher Resolution und füllt damit die Blöcke
+// von 8x8 Pixeln. Da 8 eine Zweierpotenz ist, ergibt x * (8 * resolution) in float
+// und double exakt dieselben Koordinaten wie (8 * x) * resolution
+static _Bool render_coarse(threadpool *pool, const render_plan *plan, uint16_t *counts, uint64_t tile_size,
+                           render_mode mode)
+{
+        const render_view *view = &plan->view;
+        render_plan coarse = *plan;
+        coarse.view.resolution *= PROGRESSIVE_STEP;
+        coarse.view.width = ((view->width + PROGRESSIVE_STEP - 1) / PROGRESSIVE_STEP + 3) / 4 * 4;
+        coarse.view.height = (view->height + PROGRESSIVE_STEP - 1) / PROGRESSIVE_STEP;
+        coarse.resolution *= PROGRESSIVE_STEP;
+        coarse.ref_x /= PROGRESSIVE_STEP;
+        coarse.ref_y /= PROGRESSIVE_STEP;
+
+        // Ein ausgerichtetes Raster lässt sich nicht immer auf jedes achte Pixel verkleinern.
+        // Die Vorschau rechnet dann mit den Koordinaten des Ausschnitts, die Zeilen werden
+        // im nächsten Durchlauf ohnehin neu berechnet
+        coarse.r_start = (float)view->r_start;
+        coarse.i_start = (float)view->i_start;
+        coarse.r_start_double = (double)view->r_start;
+        coarse.i_start_double = (double)view->i_start;
+        coarse.grid_x = 0;
+        coarse.grid_y = 0;
+        coarse.mirror_axis = 0;
+
+        uint16_t *samples = malloc(coarse.view.width * coarse.view.height * sizeof(uint16_t));
+        if (samples == NULL)
+                return 0;
+        render_plan_rows(pool, &coarse, NULL, samples, coarse.view.width, 0, coarse.view.height, tile_size, mode);
+
+        for (uint64_t y = 0; y < view->height; y++)
+        {
+                const uint16_t *source = samples + (y / PROGRESSIVE_STEP) * coarse.view.width;
+                uint16_t *line = counts + y * view->width;
+                for (uint64_t x = 0; x < view->width; x++)
+                        line[x] = source[x / PROGRESSIVE_STEP];
+        }
+        free(samples);
+        return 1;
+}
+
+_Bool render_plan_pass(threadpool *pool, const render_plan *plan, uint16_t *counts, unsigned pass, uint64_t tile_size,
+                       render_mode mode)
+{
+        if (pass == 0)
+                return render_coarse(pool, plan, counts, tile_size, mode);
+
+        // Die Zeilen werden in Abschnitten von tile_size^2 Pixeln verteilt, damit eine
+        // Aufgabe etwa so viel Arbeit wie eine Kachel enthält
+        const render_view *view = &plan->view;
+        uint64_t first_row = pass_rows[pass][0];
+        uint64_t row_step = pass_rows[pass][1];
+        uint64_t filled = pass_rows[pass][2];
+        if (first_row >= view->height)
+                return 1;
+        struct render_job job = {
+            .plan = plan,
+            .counts = counts,
+            .stride = view->width,
+            .y = 0,
+            .height = view->height,
+            .tile_size = tile_size * tile_size,
+            .columns = (view->width + tile_size * tile_size - 1) / (tile_size * tile_size),
+            .mode = RENDER_MODE_SCAN,
+            .first_row = first_row,
+            .row_step = row_step,
+        };
+        uint64_t rows = (view->height - first_row + row_step - 1) / row_step;
+        threadpool_run(pool, rows * job.columns, render_row, &job);
+
+        // Noch nicht berechnete Zeilen übernehmen die nächste berechnete Zeile darunter
+        for (uint64_t y = 0; y < view->height; y++)
+        {
+                if (y % filled != 0)
+                        memcpy(counts + y * view->width, counts + (y - y % filled) * view->width,
+                               view->width * sizeof(uint16_t));
+        }
+        return 1;
+}
+
+// Kontext der Stichproben eines Streifens
+struct supersample_job
+{
+        const render_plan *plan;
+        render_samples *samples;
+        unsigned grid;
+        uint64_t y;
+        size_t stride;     // Stichproben einer Zeile des feinen Rasters
+        uint16_t *scratch; // grid Zeilen des feinen Rasters je Worker
+};
+
+// grow: Vergrößert einen Puffer auf mindestens count Einträge zu je size Byte
+static _Bool grow(void **buffer, size_t *capacity, size_t count, size_t size)
+{
+        if (count <= *capacity)
+                return 1;
+        size_t target = *capacity * 2 > count ? *capacity * 2 : count;
+        void *resized = realloc(*buffer, target * size);
+        if (resized == NULL)
+                return 0;
+        *buffer = resized;
+        *capacity = target;
+        return 1;
+}
+
+// differs: Gibt an, ob sich einer der Zähler der Spalten left, x und right der Zeile
+// line von count unterscheidet. line darf NULL sein
+static _Bool differs(const uint16_t *line, uint64_t left, uint64_t x, uint64_t right, uint16_t count)
+{
+        return line != NULL && (line[left] != count || line[x] != count || line[right] != count);
+}
+
+// jitter: Fester pseudozufälliger Wert in [0;1) für den Abschnitt ab Spalte x der
+// Zeile y (splitmix64)
+static double jitter(uint64_t y, uint64_t x, uint64_t axis)
+{
+        uint64_t z = (y * 0x9E3779B97F4A7C15ULL) ^ (x * 0xBF58476D1CE4E5B9ULL) ^ (axis + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return (double)(z >> 11) * 0x1p-53;
+}
+
+// fine_plan: Plan eines um grid feineren Rasters. Das Pixel (x, y) des Plans deckt die
+// Stichproben (x * grid + i, y * grid + j) mit i, j < grid ab, die um (dx, dy)
+// Stichprobenabstände aus der linken unteren Ecke des Pixels verschoben sind. Mit
+// Störungsrechnung wird nur der Referenzpunkt relativ zu den Stichproben verschoben,
+// der Orbit bleibt derselbe
+static render_plan fine_plan(const render_plan *plan, unsigned grid, double dx, double dy)
+{
+        const render_view *view = &plan->view;
+        render_plan fine = *plan;
+        fine.view.resolution = view->resolution / grid;
+        fine.view.r_start = view->r_start + ((hp_float)dx / grid - (hp_float)0.5) * view->resolution;
+        fine.view.i_start = view->i_start + ((hp_float)dy / grid - (hp_float)0.5) * view->resolution;
+        fine.resolution = (float)fine.view.resolution;
+        fine.r_start = (float)fine.view.r_start;
+        fine.i_start = (float)fine.view.i_start;
+        fine.r_start_double = (double)fine.view.r_start;
+        fine.i_start_double = (double)fine.view.i_start;
+        fine.ref_x = plan->ref_x * grid + grid * 0.5 - dx;
+        fine.ref_y = plan->ref_y * grid + grid * 0.5 - dy;
+        fine.grid_x = 0;
+        fine.grid_y = 0;
+        fine.mirror_axis = 0;
+        return fine;
+}
+
+// supersample_row: Aufgabe des Threadpools. Berechnet alle Stichproben der Randpixel
+// einer Zeile. Benachbarte Randpixel werden zu Abschnitten aus ganzen Vierergruppen
+// zusammengefasst, deren grid x grid Stichproben je Pixel der Kernel als ein Rechteck
+// des feinen Rasters in einem Aufruf berechnet. Jeder Abschnitt erhält einen eigenen
+// zufälligen Versatz des Rasters
+static void supersample_row(void *ctx, size_t index, unsigned worker)
+{
+        struct supersample_job *job = ctx;
+        render_samples *samples = job->samples;
+        unsigned grid = job->grid;
+        uint64_t y = job->y + index;
+        uint64_t last = samples->row_start[index + 1];
+        uint16_t *scratch = job->scratch + worker * job->stride * grid;
+        for (uint64_t e = samples->row_start[index]; e < last;)
+        {
+                uint64_t first = e;
+                uint64_t start = samples->columns[e] & ~3ULL;
+                uint64_t end = start + 4;
+                while (++e < last && (samples->columns[e] & ~3ULL) <= end)
+                        end = (samples->columns[e] & ~3ULL) + 4;
+
+                render_plan fine = fine_plan(job->plan, grid, jitter(y, start, 0), jitter(y, start, 1));
+                struct render_job span = {.plan = &fine, .counts = scratch, .stride = job->stride, .y = y * grid};
+                render_rect(&span, start * grid, 0, (end - start) * grid, grid);
+
+                for (uint64_t pixel = first; pixel < e; pixel++)
+                {
+                        uint16_t *target = samples->counts + pixel * samples->per_pixel;
+                        const uint16_t *source = scratch + samples->columns[pixel] * grid;
+                        for (unsigned j = 0; j < grid; j++)
+                                memcpy(target + j * grid, source + j * job->stride, grid * sizeof(uint16_t));
+                }
+        }
+}
+
+_Bool render_plan_supersample(threadpool *pool, const render_plan *plan, const uint16_t *counts, size_t stride,
+                              uint64_t y, uint64_t height, unsigned grid, render_samples *samples)
+{
+        const render_view *view = &plan->view;
+        uint64_t width = view->width;
+        samples->per_pixel = grid * grid;
+        samples->rows = height;
+        if (!grow((void **)&samples->row_start, &samples->row_capacity, height + 1, sizeof(uint64_t)))
+                return 0;
+
+        // Randpixel suchen. Am Bildrand zählen nur die vorhandenen Nachbarn
+        uint64_t edges = 0;
+        for (uint64_t row = 0; row < height; row++)
+        {
+                samples->row_start[row] = edges;
+                const uint16_t *line = counts + row * stride;
+                const uint16_t *lower = y + row > 0 ? line - stride : NULL;
+                const uint16_t *upper = y + row + 1 < view->height ? line + stride : NULL;
+                for (uint64_t x = 0; x < width; x++)
+                {
+                        uint64_t left = x > 0 ? x - 1 : x;
+                        uint64_t right = x + 1 < width ? x + 1 : x;
+                        uint16_t count = line[x];
+                        if (!differs(line, left, x, right, count) && !differs(lower, left, x, right, count) &&
+                            !differs(upper, left, x, right, count))
+                                continue;
+                        if (!grow((void **)&samples->columns, &samples->capacity, edges + 1, sizeof(uint64_t)))
+                                return 0;
+                        samples->columns[edges++] = x;
+                }
+        }
+        samples->row_start[height] = edges;
+        if (edges == 0)
+                return 1;
+        if (!grow((void **)&samples->counts, &samples->count_capacity, edges * samples->per_pixel, sizeof(uint16_t)))
+                return 0;
+
+        struct supersample_job job = {
+            .plan = plan,
+            .samples = samples,
+            .grid = grid,
+            .y = y,
+            .stride = width * grid,
+        };
+        job.scratch = malloc(threadpool_size(pool) * job.stride * grid * sizeof(uint16_t));
+        if (job.scratch == NULL)
+                return 0;
+        threadpool_run(pool, height, supersample_row, &job);
+        free(job.scratch);
+        return 1;
+}
+
+void render_samples_apply(const render_samples *samples, const palette *palette, unsigned char *rows,
+                          ptrdiff_t stride)
+{
+        unsigned char colors[RENDER_MAX_ANTIALIAS * RENDER_MAX_ANTIALIAS * 3];
+        unsigned per_pixel = samples->per_pixel;
+        for (uint64_t row = 0; row < samples->rows; row++)
+        {
+                unsigned char *line = rows + (ptrdiff_t)row * stride;
+                for (uint64_t e = samples->row_start[row]; e < samples->row_start[row + 1]; e++)
+                {
+                        palette_apply(palette, samples->counts + e * per_pixel, colors, per_pixel);
+                        unsigned char *pixel = line + samples->columns[e] * 3;
+                        for (unsigned channel = 0; channel < 3; channel++)
+                        {
+                                unsigned sum = 0;
+                                for (unsigned sample = 0; sample < per_pixel; sample++)
+                                        sum += colors[sample * 3 + channel];
+                                pixel[channel] = (unsigned char)((sum + per_pixel / 2) / per_pixel);
+                        }
+                }
+        }
+}
+
+void render_samples_free(render_samples *samples)
+{
+        free(samples->row_start);
+        free(samples->columns);
+        free(samples->counts);
+        *samples = (render_samples){0};
+}
+
+_Bool render_stats_reset(render_stats *stats, uint64_t width, uint64_t height, uint64_t cell_size)
+{
+        uint64_t columns = (width + cell_size - 1) / cell_size;
+        uint64_t rows = (height + cell_size - 1) / cell_size;
+        if (!grow((void **)&stats->cell_time, &stats->cell_capacity, columns * rows, sizeof(uint64_t)))
+                return 0;
+        *stats = (render_stats){
+            .width = width,
+            .height = height,
+            .cell_size = cell_size,
+            .columns = columns,
+            .rows = rows,
+            .cell_time = stats->cell_time,
+            .cell_capacity = stats->cell_capacity,
+        };
+        memset(stats->cell_time, 0, columns * rows * sizeof(uint64_t));
+        return 1;
+}
+
+void render_stats_histogram(render_stats *stats, const uint16_t *counts, size_t stride, uint64_t width, uint64_t rows,
+                            int16_t max_iterations)
+{
+        for (uint64_t row = 0; row < rows; row++)
+        {
+                const uint16_t *line = counts + row * stride;
+                for (uint64_t x = 0; x < width; x++)
+                {
+                        // Klasse 1 + floor(log2(count)), die Zähler sind höchstens 32767
+                        uint16_t count = line[x];
+                        if (count >= max_iterations)
+                                stats->histogram[RENDER_STATS_BUCKETS - 1]++;
+                        else if (count == 0)
+                                stats->histogram[0]++;
+                        else
+                                stats->histogram[32 - __builtin_clz(count)]++;
+                }
+        }
+}
+
+void render_stats_free(render_stats *stats)
+{
+        free(stats->cell_time);
+        *stats = (render_stats){0};
+}
+
+void render_plan_stats(render_plan *plan, render_stats *stats)
+{
+        plan->stats = stats;
+        if (stats != NULL)
+                stats->lanes = plan->lanes;
+}
+
+void render_plan_destroy(render_plan *plan)
+{
+        if (plan == NULL)
+                return;
+        reference_orbit_destroy(plan->orbit);
+        free(plan);
+}
@@ -0,0 +1,263 @@
+// Include Guards
+#ifndef RENDER_H
+#define RENDER_H
+#include <stdint.h>
+#include "cache.h"
+#include "deepzoom.h"
+#include "kernel.h"
+#include "mandelbrot.h"
+#include "palette.h"
+#include "threadpool.h"
+#include "writer.h"
+
+// Genauigkeitsstufen der Berechnung. PRECISION_AUTO wählt anhand des Verhältnisses
+// von Resolution zu Koordinatenbetrag die günstigste ausreichende Stufe
+typedef enum
+{
+        PRECISION_AUTO,
+        PRECISION_FLOAT,
+        PRECISION_DOUBLE,
+        PRECISION_PERTURBATION,
+} precision_tier;
+
+// Reihenfolge, in der die Pixel einer Kachel berechnet werden. RENDER_MODE_SUBDIVIDE
+// berechnet nur die Ränder von Rechtecken und füllt diese, wenn der gesamte Rand
+// dieselbe Iterationszahl hat (Mariani-Silver). Da die Mandelbrotmenge und ihre
+// Iterationsbänder zusammenhängend sind, hat dann auch das Innere diese Zahl
+typedef enum
+{
+        RENDER_MODE_SCAN,
+        RENDER_MODE_SUBDIVIDE,
+} render_mode;
+
+// Überprüfung des Ergebnisses mit der Referenzimplementierung. VERIFY_SAMPLED
+// berechnet nur zufällig gewählte Zeilen jedes Streifens ein zweites Mal
+typedef enum
+{
+        VERIFY_OFF,
+        VERIFY_FULL,
+        VERIFY_SAMPLED,
+} verify_mode;
+
+// Einstellungen, die nicht den Bildausschnitt, sondern die Art der Berechnung betreffen
+typedef struct
+{
+        unsigned threads;                       // Anzahl der Worker Threads inklusive des Hauptthreads
+        uint64_t tile_size;                     // Kantenlänge der Kacheln in Pixeln (Vielfaches von 4)
+        kernel_variant kernel;                  // Zu verwendender Kachel-Kernel
+        precision_tier precision;               // Zu verwendende Genauigkeitsstufe
+        uint64_t strip_height;                  // Zeilen pro Streifen (0: ganzes Bild auf einmal)
+        image_format format;                    // Dateiformat des Bildes
+        render_mode mode;                       // Reihenfolge der Berechnung innerhalb der Kacheln
+        lane_mode lanes;                        // Zuordnung von Pixeln zu Vektorelementen
+        verify_mode verify;                     // Überprüfung mit der Referenzimplementierung
+        double sample_rate;                     // Anteil der überprüften Zeilen bei VERIFY_SAMPLED
+        palette_scheme palettes[PALETTE_COUNT]; // Farbschemata, je eines pro Ausgabedatei
+        unsigned palette_count;                 // Anzahl der Farbschemata (mindestens 1)
+        const char *cache_path;                 // Datei des Kachel-Caches (NULL: kein Cache)
+        uint64_t cache_size;                    // Maximale Größe des Kachel-Caches in Byte
+        _Bool progressive;                      // Vorschau in mehreren Durchläufen (s. render_plan_pass)
+        unsigned antialias;                     // Stichproben je Kante eines Randpixels (0, 1: keine Glättung)
+        const char *stats_path;                 // CSV Datei der Zeitkarte, schaltet render_stats ein (NULL: aus)
+        _Bool mirror;                           // Zeilen unterhalb bzw. oberhalb der reellen Achse spiegeln (s. render_plan_mirror_axis)
+} render_options;
+
+// Bildausschnitt. Die Koordinaten werden mit vierfacher Genauigkeit gehalten und
+// erst für die jeweilige Genauigkeitsstufe gerundet
+typedef struct
+{
+        hp_float r_start;
+        hp_float i_start;
+        double resolution;
+        int16_t max_iterations;
+        uint64_t width;
+        uint64_t height;
+} render_view;
+
+// precision_parse: Übersetzt den Namen einer Genauigkeitsstufe ("auto", "float",
+// "double", "perturbation"). Gibt 0 zurück, falls der Name unbekannt ist
+_Bool precision_parse(const char *name, precision_tier *precision);
+
+// precision_name: Gibt den Namen einer Genauigkeitsstufe zurück
+const char *precision_name(precision_tier precision);
+
+// render_mode_parse: Übersetzt den Namen eines Modus ("scan", "subdivide"). Gibt 0
+// zurück, falls der Name unbekannt ist
+_Bool render_mode_parse(const char *name, render_mode *mode);
+
+// render_mode_name: Gibt den Namen eines Modus zurück
+const char *render_mode_name(render_mode mode);
+
+// verify_mode_parse: Übersetzt den Namen einer Überprüfung ("off", "full", "sampled").
+// Gibt 0 zurück, falls der Name unbekannt ist
+_Bool verify_mode_parse(const char *name, verify_mode *verify);
+
+// verify_mode_name: Gibt den Namen einer Überprüfung zurück
+const char *verify_mode_name(verify_mode verify);
+
+// precision_resolve: Ersetzt PRECISION_AUTO durch die für den Ausschnitt
+// [r_start;r_end] x [i_start;i_end] mit der Resolution ausreichende Stufe
+precision_tier precision_resolve(precision_tier precision, hp_float r_start, hp_float r_end,
+                                 hp_float i_start, hp_float i_end, double resolution);
+
+// render_dimension: Anzahl der Pixel zwischen start und end, auf ein Vielfaches
+// von 4 verkleinert. Mit einfacher Genauigkeit wird wie bisher in float gerechnet
+uint64_t render_dimension(hp_float start, hp_float end, double resolution, precision_tier precision);
+
+// Für einen Bildausschnitt vorbereitete Berechnung (s. render.c). Enthält die auf
+// die Genauigkeitsstufe gerundeten Koordinaten und gegebenenfalls den Referenzorbit
+typedef struct render_plan render_plan;
+
+// render_plan_create: Bereitet die Berechnung des Ausschnitts mit dem Kernel der
+// Genauigkeitsstufe vor. Liegt die reelle Achse auf einer Zeile, werden die
+// Imaginärteile relativ zu ihr berechnet. Gibt NULL zurück, falls kein Speicher
+// verfügbar ist
+render_plan *render_plan_create(const render_view *view, kernel_variant kernel, lane_mode lanes, precision_tier precision);
+
+// render_plan_create_reference: Wie render_plan_create mit der C Referenzimplementierung.
+// Mit fma rechnet sie mit denselben FMA Rundungen wie die AVX2 und AVX-512 Kernel
+// (s. kernel_uses_fma), deren Zähler dann exakt übereinstimmen müssen
+render_plan *render_plan_create_reference(const render_view *view, precision_tier precision, _Bool fma);
+
+// render_plan_mirror_axis: Die Menge ist symmetrisch zur reellen Achse. Gibt axis
+// zurück, falls die Zeilen y und axis - y des Plans exakt entgegengesetzte
+// Imaginärteile und damit dieselben Iterationszähler haben. Das ist der Fall, wenn
+// die Achse auf einer Zeile liegt, die nicht die unterste oder oberste ist. Sonst und
+// mit Störungsrechnung, deren Referenzorbit nicht auf der Achse liegt, wird 0
+// zurückgegeben
+uint64_t render_plan_mirror_axis(const render_plan *plan);
+
+// render_plan_rows: Berechnet die Iterationszähler der Zeilen [y;y+height) des Bildes
+// in Kacheln der Kantenlänge tile_size auf allen Workern des Pools. Die Zeile y wird
+// ab counts, jede weitere stride Pixel danach geschrieben. Ist ein Cache angegeben,
+// werden dort vorhandene Kacheln übernommen und berechnete Kacheln abgelegt
+void render_plan_rows(threadpool *pool, const render_plan *plan, tile_cache *cache, uint16_t *counts, size_t stride,
+                      uint64_t y, uint64_t height, uint64_t tile_size, render_mode mode);
+
+// render_plan_align: Richtet den Plan auf das Raster des Ausschnitts grid aus, falls
+// sein Ausschnitt um ganze, nicht negative Pixelzahlen dagegen verschoben ist und
+// dieselbe Resolution hat. Der Kernel rechnet dann mit den Koordinaten von grid und
+// dem Index der Pixel darin, sodass alle so ausgerichteten Pläne dasselbe Pixel mit
+// denselben Koordinaten berechnen. Gibt 0 zurück und lässt den Plan unverändert, falls
+// das nicht möglich ist oder mit Störungsrechnung gerechnet wird
+_Bool render_plan_align(render_plan *plan, const render_view *grid);
+
+// render_plan_reuse: Berechnet das ganze Bild des Plans mit einem Zeilenabstand von
+// view.width Pixeln nach counts. Kacheln, die vollständig im Bild des vorherigen Plans
+// (previous_counts) liegen, werden daraus übernommen: Sind beide Pläne auf dasselbe
+// Raster ausgerichtet (s. render_plan_align), werden ihre Zähler kopiert und stimmen
+// exakt mit einer Neuberechnung überein. Mit fill werden beim Zoomen außerdem Kacheln
+// gefüllt, deren überdeckter Bereich im vorherigen Bild einheitlich ist. Das ist
+// verlustbehaftet, da so aufgelöste Details verloren gehen. Nur die übrigen Kacheln,
+// etwa ein neu sichtbarer Rand, werden berechnet. previous darf NULL sein. Gibt die
+// Anzahl der übernommenen Kacheln zurück
+uint64_t render_plan_reuse(threadpool *pool, const render_plan *plan, const render_plan *previous,
+                           const uint16_t *previous_counts, uint16_t *counts, uint64_t tile_size, render_mode mode,
+                           _Bool fill);
+
+// Anzahl der Durchläufe des progressiven Modus (s. render_plan_pass)
+#define RENDER_PASSES 5
+
+// render_plan_pass: Berechnet einen Durchlauf des progressiven Modus für das ganze
+// Bild mit einem Zeilenabstand von view.width Pixeln. Durchlauf 0 berechnet jedes
+// achte Pixel jeder achten Zeile, die Durchläufe 1 bis 4 die noch fehlenden Zeilen
+// im Abstand von 8 (ab Zeile 0 und 4), 4 und 2 (ähnlich GIF Interlacing). Nur die
+// Pixel des ersten Durchlaufs werden ein zweites Mal berechnet (1/64 des Bildes),
+// alle übrigen genau einmal. Nach jedem Durchlauf werden die Lücken mit den nächsten
+// berechneten Pixeln gefüllt, sodass counts eine vollständige Vorschau enthält. Nach
+// Durchlauf RENDER_PASSES - 1 ist das Bild fertig. Gibt 0 zurück, falls kein
+// Speicher verfügbar ist
+_Bool render_plan_pass(threadpool *pool, const render_plan *plan, uint16_t *counts, unsigned pass, uint64_t tile_size,
+                       render_mode mode);
+
+// Größte Kantenlänge des Stichprobenrasters der Kantenglättung
+#define RENDER_MAX_ANTIALIAS 8
+
+// Zusätzliche Stichproben der Randpixel eines Streifens (s. render_plan_supersample).
+// Die Puffer wachsen mit und werden für weitere Streifen wiederverwendet
+typedef struct
+{
+        unsigned per_pixel;    // Stichproben je Randpixel
+        uint64_t rows;         // Zeilen des Streifens
+        uint64_t *row_start;   // Index des ersten Randpixels jeder Zeile, rows + 1 Einträge
+        uint64_t *columns;     // Spalte jedes Randpixels
+        uint16_t *counts;      // per_pixel Zähler je Randpixel
+        size_t row_capacity;   // Reservierte Einträge von row_start
+        size_t capacity;       // Reservierte Einträge von columns
+        size_t count_capacity; // Reservierte Einträge von counts
+} render_samples;
+
+// render_plan_supersample: Sucht in den Zeilen [y;y+height) die Randpixel, deren
+// Iterationszähler sich von einem der acht Nachbarn unterscheidet, und berechnet für
+// jedes grid x grid zusätzliche Stichproben. Die Stichproben bilden ein Raster mit dem
+// Abstand resolution / grid, das für jeden Abschnitt benachbarter Randpixel um einen
+// festen zufälligen Bruchteil verschoben ist. So berechnet der Kernel die Stichproben
+// eines Abschnitts mit vollen Vektoren in einem Aufruf. Die Zeile y liegt bei
+// counts, jede weitere stride Pixel danach.
+// Die Zeilen y - 1 und y + height müssen ebenfalls berechnet sein, soweit sie im Bild
+// liegen. Gibt 0 zurück, falls kein Speicher verfügbar ist
+_Bool render_plan_supersample(threadpool *pool, const render_plan *plan, const uint16_t *counts, size_t stride,
+                              uint64_t y, uint64_t height, unsigned grid, render_samples *samples);
+
+// render_samples_apply: Überschreibt die Farbe jedes Randpixels in den mit palette
+// eingefärbten Zeilen rows (drei Byte je Pixel, Zeile y + 1 liegt stride Byte nach
+// Zeile y) mit dem Mittelwert der Farben seiner Stichproben
+void render_samples_apply(const render_samples *samples, const palette *palette, unsigned char *rows,
+                          ptrdiff_t stride);
+
+// render_samples_free: Gibt die Puffer der Stichproben frei
+void render_samples_free(render_samples *samples);
+
+// Klassen des Histogramms der Iterationszähler: 0, 1, 2-3, 4-7 usw. bis 16384-32767
+// sowie zuletzt die Punkte der Mandelbrotmenge
+#define RENDER_STATS_BUCKETS 17
+
+// Messwerte einer Berechnung (s. render_plan_stats). Die Zähler des Kernels werden
+// nach jedem Aufruf aus den geschriebenen Iterationszählern abgeleitet: Eine Gruppe
+// von lanes Pixeln durchläuft die Iterationsschleife so oft wie ihr langsamstes
+// Element, die übrigen Elemente sind so lange ausmaskiert. Punkte in der Hauptkardioide
+// und im Kreis der Periode 2 kosten keine Iteration. Punkte, die die Zyklenerkennung
+// vorzeitig beendet, zählen mit i_max, die Werte sind dort also obere Schranken
+typedef struct
+{
+        uint64_t width;            // Bildgröße in Pixeln
+        uint64_t height;
+        uint64_t cell_size;        // Kantenlänge der Zellen der Zeitkarte in Pixeln
+        uint64_t columns;          // Zellen der Zeitkarte je Zeile
+        uint64_t rows;             // Zeilen der Zeitkarte, Zeile 0 liegt bei i_start
+        uint64_t *cell_time;       // Kernelzeit je Zelle in Nanosekunden
+        size_t cell_capacity;      // Reservierte Einträge von cell_time
+        uint64_t lanes;            // Vektorbreite des Kernels
+        uint64_t calls;            // Aufrufe des Kernels
+        uint64_t pixels;           // Vom Kernel berechnete Pixel, inklusive Stichproben
+        uint64_t iterations;       // Von ihnen benötigte Iterationen
+        uint64_t lane_iterations;  // Durchläufe der Iterationsschleife mal lanes
+        uint64_t histogram[RENDER_STATS_BUCKETS]; // Iterationszähler der Bildpixel
+        double render_time;        // Sekunden für Berechnung inklusive Kantenglättung
+        double color_time;         // Sekunden für das Einfärben
+        double write_time;         // Sekunden für das Schreiben und Komprimieren der Dateien
+} render_stats;
+
+// render_stats_reset: Setzt die Messwerte für ein Bild der Größe width x height zurück
+// und teilt die Zeitkarte in Zellen der Kantenlänge cell_size. Gibt 0 zurück, falls
+// kein Speicher verfügbar ist
+_Bool render_stats_reset(render_stats *stats, uint64_t width, uint64_t height, uint64_t cell_size);
+
+// render_stats_histogram: Zählt die Iterationszähler von rows Zeilen zu je width
+// Pixeln ab counts im Histogramm. Zeile n + 1 liegt stride Pixel nach Zeile n
+void render_stats_histogram(render_stats *stats, const uint16_t *counts, size_t stride, uint64_t width, uint64_t rows,
+                            int16_t max_iterations);
+
+// render_stats_free: Gibt die Zeitkarte frei
+void render_stats_free(render_stats *stats);
+
+// render_plan_stats: Erfasst ab sofort jeden Kernelaufruf des Plans und der aus ihm
+// abgeleiteten Pläne (progressiver Modus, Kantenglättung) in stats. Die Zähler werden
+// atomar addiert, alle Worker können also gleichzeitig rechnen. NULL schaltet die
+// Erfassung wieder ab
+void render_plan_stats(render_plan *plan, render_stats *stats);
+
+// render_plan_destroy: Gibt eine vorbereitete Berechnung frei
+void render_plan_destroy(render_plan *plan);
+
+#endif // !RENDER_H
@@ -0,0 +1,676 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "server.h"
+#include "timer.h"
+
+// Bereich der Kachel 0/0/0: Quadrat der Kantenlänge WORLD_SIZE ab (WORLD_R, WORLD_I)
+#define WORLD_R -2.5
+#define WORLD_I -2.0
+#define WORLD_SIZE 4.0
+
+// Anzahl der Listen im Hash der gespeicherten Kacheln
+#define CACHE_BUCKETS 4096
+
+// Latenzen werden in Zweierpotenzen von Millisekunden gezählt: < 1 ms, < 2 ms, ...,
+// < 1024 ms und der Rest
+#define LATENCY_BUCKETS 12
+
+// Maximale Länge einer Anfrage inklusive Header
+#define REQUEST_SIZE 4096
+
+// Art der Antwort auf eine Kachelanfrage
+typedef enum
+{
+        TILE_HIT,       // Aus dem Speicher übernommen
+        TILE_MISS,      // Neu berechnet
+        TILE_COALESCED, // Während der Berechnung durch eine andere Verbindung angefragt
+        TILE_FAILED,    // Berechnung oder Kodierung fehlgeschlagen
+} tile_outcome;
+
+// Kodierte Kachel im Speicher. Die Kacheln bilden eine Liste von der zuletzt zur am
+// längsten nicht verwendeten und je Hash eine Liste zum Suchen
+struct tile_entry
+{
+        unsigned zoom;
+        uint64_t x;
+        uint64_t y;
+        unsigned char *data;
+        size_t size;
+        struct tile_entry *newer;
+        struct tile_entry *older;
+        struct tile_entry *next;
+};
+
+// Kachel, die gerade von einer Verbindung berechnet wird
+struct flight
+{
+        unsigned zoom;
+        uint64_t x;
+        uint64_t y;
+        struct flight *next;
+};
+
+struct server
+{
+        const render_options *options;
+        const server_settings *settings;
+        kernel_variant kernel;
+        palette *palette;
+        const uint32_t *colors;
+        unsigned color_count;
+        int listener;
+        _Bool stopping;
+
+        // Der Threadpool und der Kachel-Cache werden immer nur von einer Verbindung
+        // gleichzeitig verwendet. Eine Kachel nutzt ohnehin alle Worker
+        pthread_mutex_t render_lock;
+        threadpool *pool;
+        tile_cache *cache;
+
+        // Alle folgenden Felder sind durch lock geschützt. finished wird nach jeder
+        // fertigen Berechnung signalisiert
+        pthread_mutex_t lock;
+        pthread_cond_t finished;
+        struct tile_entry *buckets[CACHE_BUCKETS];
+        struct tile_entry *newest;
+        struct tile_entry *oldest;
+        uint64_t memory_used;
+        uint64_t entries;
+        struct flight *flights;
+        uint64_t requests[TILE_FAILED + 1];
+        uint64_t latency[LATENCY_BUCKETS];
+};
+
+// Thread einer Verbindung mit eigenem Puffer für die Iterationszähler einer Kachel
+struct connection
+{
+        pthread_t thread;
+        struct server *server;
+        uint16_t *counts;
+        _Bool started;
+};
+
+// tile_hash: Verteilt die Kacheln gleichmäßig auf die Listen des Hashs
+static size_t tile_hash(unsigned zoom, uint64_t x, uint64_t y)
+{
+        uint64_t hash = (x * 0x9E3779B97F4A7C15ULL) ^ (y * 0xC2B2AE3D27D4EB4FULL) ^ zoom;
+        hash ^= hash >> 29;
+        return (size_t)(hash % CACHE_BUCKETS);
+}
+
+// cache_find: Sucht eine Kachel im Speicher und markiert sie als zuletzt verwendet
+static struct tile_entry *cache_find(struct server *server, unsigned zoom, uint64_t x, uint64_t y)
+{
+        struct tile_entry *entry = server->buckets[tile_hash(zoom, x, y)];
+        while (entry != NULL && (entry->zoom != zoom || entry->x != x || entry->y != y))
+                entry = entry->next;
+        if (entry == NULL || entry == server->newest)
+                return entry;
+
+        // Aus der Liste lösen und vorne einhängen
+        entry->newer->older = entry->older;
+        if (entry->older != NULL)
+                entry->older->newer = entry->newer;
+        else
+                server->oldest = entry->newer;
+        entry->newer = NULL;
+        entry->older = server->newest;
+        server->newest->newer = entry;
+        server->newest = entry;
+        return entry;
+}
+
+// cache_evict: Entfernt die am längsten nicht verwendete Kachel
+static void cache_evict(struct server *server)
+{
+        struct tile_entry *entry = server->oldest;
+        struct tile_entry **link = &server->buckets[tile_hash(entry->zoom, entry->x, entry->y)];
+        while (*link != entry)
+                link = &(*link)->next;
+        *link = entry->next;
+
+        server->oldest = entry->newer;
+        if (server->oldest != NULL)
+                server->oldest->older = NULL;
+        else
+                server->newest = NULL;
+        server->memory_used -= entry->size;
+        server->entries--;
+        free(entry->data);
+        free(entry);
+}
+
+// cache_insert: Legt eine Kopie der kodierten Kachel im Speicher ab und verdrängt
+// dafür die am längsten nicht verwendeten Kacheln. Kacheln, die allein größer als der
+// Speicher sind, und fehlender Speicher werden ignoriert
+static void cache_insert(struct server *server, unsigned zoom, uint64_t x, uint64_t y, const unsigned char *data,
+                         size_t size)
+{
+        if (size > server->settings->memory_size || cache_find(server, zoom, x, y) != NULL)
+                return;
+        struct tile_entry *entry = malloc(sizeof(*entry));
+        unsigned char *copy = malloc(size);
+        if (entry == NULL || copy == NULL)
+        {
+                free(entry);
+                free(copy);
+                return;
+        }
+        while (server->memory_used + size > server->settings->memory_size)
+                cache_evict(server);
+
+        memcpy(copy, data, size);
+        size_t bucket = tile_hash(zoom, x, y);
+        *entry = (struct tile_entry){
+            .zoom = zoom,
+            .x = x,
+            .y = y,
+            .data = copy,
+            .size = size,
+            .older = server->newest,
+            .next = server->buckets[bucket],
+        };
+        server->buckets[bucket] = entry;
+        if (server->newest != NULL)
+                server->newest->newer = entry;
+        else
+                server->oldest = entry;
+        server->newest = entry;
+        server->memory_used += size;
+        server->entries++;
+}
+
+// flight_find: Gibt an, ob die Kachel gerade von einer Verbindung berechnet wird
+static _Bool flight_find(const struct server *server, unsigned zoom, uint64_t x, uint64_t y)
+{
+        for (const struct flight *flight = server->flights; flight != NULL; flight = flight->next)
+        {
+                if (flight->zoom == zoom && flight->x == x && flight->y == y)
+                        return 1;
+        }
+        return 0;
+}
+
+// flight_remove: Entfernt eine fertige Berechnung aus der Liste
+static void flight_remove(struct server *server, const struct flight *flight)
+{
+        struct flight **link = &server->flights;
+        while (*link != flight)
+                link = &(*link)->next;
+        *link = flight->next;
+}
+
+// render_png: Berechnet die Kachel und kodiert sie als PNG. *data muss mit free
+// freigegeben werden. Gibt 0 zurück, falls kein Speicher verfügbar ist
+static _Bool render_png(struct server *server, uint16_t *counts, unsigned zoom, uint64_t x, uint64_t y,
+                        unsigned char **data, size_t *size)
+{
+        const render_options *options = server->options;
+
+        // Die Kantenlänge ist eine Zweierpotenz, die Koordinaten sind daher exakt.
+        // Zeile 0 einer Kachel liegt bei i_start, also am unteren Rand
+        hp_float side = (hp_float)WORLD_SIZE / (hp_float)(1ULL << zoom);
+        hp_float resolution = side / SERVER_TILE_SIZE;
+        render_view view = {
+            .r_start = (hp_float)WORLD_R + (hp_float)x * side,
+            .i_start = (hp_float)WORLD_I + (hp_float)((1ULL << zoom) - 1 - y) * side,
+            .resolution = (double)resolution,
+            .max_iterations = server->settings->max_iterations,
+            .width = SERVER_TILE_SIZE,
+            .height = SERVER_TILE_SIZE,
+        };
+        precision_tier precision = precision_resolve(options->precision, view.r_start, view.r_start + side, view.i_start,
+                                                     view.i_start + side, view.resolution);
+        render_plan *plan = render_plan_create(&view, server->kernel, options->lanes, precision);
+        if (plan == NULL)
+                return 0;
+        pthread_mutex_lock(&server->render_lock);
+        render_plan_rows(server->pool, plan, server->cache, counts, SERVER_TILE_SIZE, 0, SERVER_TILE_SIZE,
+                         options->tile_size, options->mode);
+        pthread_mutex_unlock(&server->render_lock);
+        render_plan_destroy(plan);
+
+        // Kodiert wird im Thread der Verbindung, damit andere Kacheln währenddessen
+        // auf dem Threadpool berechnet werden können
+        *data = NULL;
+        *size = 0;
+        FILE *fp = open_memstream((char **)data, size);
+        if (fp == NULL)
+                return 0;
+        image_writer_settings settings = {
+            .rows_per_strip = SERVER_TILE_SIZE,
+            .colors = server->colors,
+            .color_count = server->color_count,
+        };
+        image_writer *writer = image_writer_open_stream(fp, IMAGE_FORMAT_PNG, SERVER_TILE_SIZE, SERVER_TILE_SIZE, &settings);
+        if (writer == NULL)
+        {
+                fclose(fp);
+                free(*data);
+                return 0;
+        }
+        ptrdiff_t stride;
+        unsigned char *rows = image_writer_rows(writer, 0, SERVER_TILE_SIZE, &stride);
+        if (rows != NULL)
+                palette_index_rows(server->palette, counts, SERVER_TILE_SIZE, rows, stride, SERVER_TILE_SIZE,
+                                   SERVER_TILE_SIZE);
+        if (!image_writer_close(writer) || rows == NULL)
+        {
+                free(*data);
+                return 0;
+        }
+        return 1;
+}
+
+// fetch_tile: Gibt die kodierte Kachel aus dem Speicher zurück oder berechnet sie.
+// Wird sie bereits von einer anderen Verbindung berechnet, wird auf deren Ergebnis
+// gewartet. *data muss mit free freigegeben werden
+static tile_outcome fetch_tile(struct server *server, uint16_t *counts, unsigned zoom, uint64_t x, uint64_t y,
+                               unsigned char **data, size_t *size)
+{
+        struct flight flight = {.zoom = zoom, .x = x, .y = y};
+        _Bool waited = 0;
+        pthread_mutex_lock(&server->lock);
+        for (;;)
+        {
+                struct tile_entry *entry = cache_find(server, zoom, x, y);
+                if (entry != NULL)
+                {
+                        *data = malloc(entry->size);
+                        *size = entry->size;
+                        if (*data != NULL)
+                                memcpy(*data, entry->data, entry->size);
+                        pthread_mutex_unlock(&server->lock);
+                        return *data == NULL ? TILE_FAILED : waited ? TILE_COALESCED : TILE_HIT;
+                }
+
+                // Ist die Berechnung fertig, liegt die Kachel im Speicher. Passt sie
+                // nicht hinein oder ist sie fehlgeschlagen, wird sie selbst berechnet
+                if (!flight_find(server, zoom, x, y))
+                        break;
+                waited = 1;
+                pthread_cond_wait(&server->finished, &server->lock);
+        }
+        flight.next = server->flights;
+        server->flights = &flight;
+        pthread_mutex_unlock(&server->lock);
+
+        _Bool rendered = render_png(server, counts, zoom, x, y, data, size);
+
+        pthread_mutex_lock(&server->lock);
+        if (rendered)
+                cache_insert(server, zoom, x, y, *data, *size);
+        flight_remove(server, &flight);
+        pthread_cond_broadcast(&server->finished);
+        pthread_mutex_unlock(&server->lock);
+        return rendered ? TILE_MISS : TILE_FAILED;
+}
+
+// format_stats: Schreibt die Kennzahlen des Servers als Text mit prefix vor jeder
+// Zeile nach out
+static void format_stats(struct server *server, const char *prefix, char *out, size_t size)
+{
+        pthread_mutex_lock(&server->lock);
+        uint64_t hits = server->requests[TILE_HIT] + server->requests[TILE_COALESCED];
+        uint64_t total = hits + server->requests[TILE_MISS] + server->requests[TILE_FAILED];
+        size_t length = snprintf(out, size,
+                                 "%sAnfragen: %" PRIu64 "\n"
+                                 "%sTreffer: %" PRIu64 " (%.2f Prozent), davon %" PRIu64 " während der Berechnung\n"
+                                 "%sBerechnet: %" PRIu64 "\n"
+                                 "%sFehlgeschlagen: %" PRIu64 "\n"
+                                 "%sIm Speicher: %" PRIu64 " Kacheln, %" PRIu64 " von %" PRIu64 " Byte\n"
+                                 "%sLatenz:\n",
+                                 prefix, total, prefix, hits, total > 0 ? 100.0 * hits / total : 0.0,
+                                 server->requests[TILE_COALESCED], prefix, server->requests[TILE_MISS], prefix,
+                                 server->requests[TILE_FAILED], prefix, server->entries, server->memory_used,
+                                 server->settings->memory_size, prefix);
+        for (unsigned bucket = 0; bucket < LATENCY_BUCKETS && length < size; bucket++)
+        {
+                if (bucket + 1 < LATENCY_BUCKETS)
+                        length += snprintf(out + length, size - length, "%s  < %u ms: %" PRIu64 "\n", prefix,
+                                           1U << bucket, server->latency[bucket]);
+                else
+                        length += snprintf(out + length, size - length, "%s  >= %u ms: %" PRIu64 "\n", prefix,
+                                           1U << (bucket - 1), server->latency[bucket]);
+        }
+        pthread_mutex_unlock(&server->lock);
+}
+
+// record_latency: Zählt eine beantwortete Kachelanfrage
+static void record_latency(struct server *server, tile_outcome outcome, double seconds)
+{
+        unsigned bucket = 0;
+        while (bucket + 1 < LATENCY_BUCKETS && seconds * 1000 >= (double)(1U << bucket))
+                bucket++;
+        pthread_mutex_lock(&server->lock);
+        server->requests[outcome]++;
+        server->latency[bucket]++;
+        pthread_mutex_unlock(&server->lock);
+}
+
+// send_all: Sendet size Byte vollständig. Gibt 0 zurück, falls die Verbindung
+// abgebrochen wurde
+static _Bool send_all(int fd, const void *data, size_t size)
+{
+        const char *bytes = data;
+        while (size > 0)
+        {
+                ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+                if (sent < 0 && errno == EINTR)
+                        continue;
+                if (sent <= 0)
+                        return 0;
+                bytes += sent;
+                size -= (size_t)sent;
+        }
+        return 1;
+}
+
+// respond: Sendet eine vollständige Antwort und schließt danach die Verbindung
+static void respond(int fd, const char *status, const char *type, const char *extra, const void *body, size_t size)
+{
+        char header[512];
+        int length = snprintf(header, sizeof(header),
+                              "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%sConnection: close\r\n\r\n",
+                              status, type, size, extra);
+        if (send_all(fd, header, (size_t)length))
+                send_all(fd, body, size);
+}
+
+// respond_error: Antwortet mit einem Statuscode und dessen Text als Inhalt
+static void respond_error(int fd, const char *status)
+{
+        char body[64];
+        int length = snprintf(body, sizeof(body), "%s\n", status);
+        respond(fd, status, "text/plain; charset=utf-8", "", body, (size_t)length);
+}
+
+// read_request: Liest die Anfrage bis zum Ende der Header. Gibt 0 zurück, falls die
+// Verbindung vorher geschlossen wurde oder die Anfrage zu lang ist
+static _Bool read_request(int fd, char *request, size_t size)
+{
+        size_t length = 0;
+        while (length + 1 < size)
+        {
+                ssize_t received = recv(fd, request + length, size - 1 - length, 0);
+                if (received < 0 && errno == EINTR)
+                        continue;
+                if (received <= 0)
+                        return 0;
+                length += (size_t)received;
+                request[length] = '\0';
+                if (strstr(request, "\r\n\r\n") != NULL)
+                        return 1;
+        }
+        return 0;
+}
+
+// handle_connection: Beantwortet eine Anfrage. Jede Verbindung trägt genau eine Anfrage
+static void handle_connection(struct server *server, struct connection *connection, int fd)
+{
+        char request[REQUEST_SIZE];
+        if (!read_request(fd, request, sizeof(request)))
+                return;
+        double start = curtime();
+
+        char method[8];
+        char target[256];
+        if (sscanf(request, "%7s %255s", method, target) != 2)
+        {
+                respond_error(fd, "400 Bad Request");
+                return;
+        }
+        if (strcmp(method, "GET"))
+        {
+                respond_error(fd, "405 Method Not Allowed");
+                return;
+        }
+        target[strcspn(target, "?")] = '\0';
+
+        if (!strcmp(target, "/stats"))
+        {
+                char stats[1024];
+                format_stats(server, "", stats, sizeof(stats));
+                respond(fd, "200 OK", "text/plain; charset=utf-8", "", stats, strlen(stats));
+                return;
+        }
+
+        // Kacheln außerhalb der Ebene oder der Zoomstufen gibt es nicht
+        unsigned zoom;
+        uint64_t x, y;
+        int consumed = 0;
+        if (sscanf(target, "/%u/%" SCNu64 "/%" SCNu64 "%n", &zoom, &x, &y, &consumed) != 3 || consumed == 0 ||
+            (target[consumed] != '\0' && strcmp(target + consumed, ".png")) || zoom > SERVER_MAX_ZOOM ||
+            x >= 1ULL << zoom || y >= 1ULL << zoom)
+        {
+                respond_error(fd, "404 Not Found");
+                return;
+        }
+
+        unsigned char *data;
+        size_t size;
+        tile_outcome outcome = fetch_tile(server, connection->counts, zoom, x, y, &data, &size);
+        if (outcome == TILE_FAILED)
+        {
+                respond_error(fd, "500 Internal Server Error");
+        }
+        else
+        {
+                static const char *names[] = {"hit", "miss", "coalesced"};
+                char extra[64];
+                snprintf(extra, sizeof(extra), "Cache-Control: max-age=86400\r\nX-Tile-Cache: %s\r\n", names[outcome]);
+                respond(fd, "200 OK", "image/png", extra, data, size);
+                free(data);
+        }
+        record_latency(server, outcome, curtime() - start);
+}
+
+// connection_main: Nimmt Verbindungen an, bis der Server beendet wird
+static void *connection_main(void *arg)
+{
+        struct connection *connection = arg;
+        struct server *server = connection->server;
+        for (;;)
+        {
+                int fd = accept(server->listener, NULL, NULL);
+                if (fd < 0)
+                {
+                        if (__atomic_load_n(&server->stopping, __ATOMIC_ACQUIRE))
+                                break;
+                        continue;
+                }
+
+                // Langsame Clients blockieren den Thread höchstens einige Sekunden
+                struct timeval timeout = {.tv_sec = 5};
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                handle_connection(server, connection, fd);
+                close(fd);
+        }
+        return NULL;
+}
+
+// open_listener: Öffnet den Socket auf 127.0.0.1:port. Gibt -1 zurück, falls der Port
+// nicht verfügbar ist
+static int open_listener(unsigned port)
+{
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+                return -1;
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        struct sockaddr_in address = {
+            .sin_family = AF_INET,
+            .sin_port = htons((uint16_t)port),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        if (bind(fd, (struct sockaddr *)&address, sizeof(address)) || listen(fd, 64))
+        {
+                close(fd);
+                return -1;
+        }
+        return fd;
+}
+
+int serve(const render_options *options, const server_settings *settings)
+{
+        if (settings->max_iterations < 0)
+        {
+                fprintf(stderr, "   Die Anzahl der maximalen Iterationen darf nicht kleiner 0 sein.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        if (settings->port == 0 || settings->port > 65535)
+        {
+                fprintf(stderr, "   Der Port muss im Interval [1;65535] liegen.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        kernel_variant kernel = kernel_resolve(options->kernel);
+        if (!kernel_supported(kernel))
+        {
+                fprintf(stderr, "   Der Kernel %s wird von diesem Prozessor nicht unterstützt.\r\n", kernel_name(kernel));
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+
+        // Kacheln werden mit dem ersten Farbschema als indiziertes PNG kodiert
+        palette *palette = palette_create(options->palettes[0], settings->max_iterations, 1);
+        if (palette == NULL)
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+                return EXIT_FAILURE;
+        }
+        unsigned color_count;
+        const uint32_t *colors = palette_colors(palette, &color_count);
+        if (colors == NULL)
+        {
+                fprintf(stderr, "   Das Farbschema %s hat für PNG Kacheln zu viele Farben.\r\n",
+                        palette_name(options->palettes[0]));
+                fflush(stderr);
+                palette_destroy(palette);
+                return EXIT_FAILURE;
+        }
+
+        int listener = open_listener(settings->port);
+        if (listener < 0)
+        {
+                fprintf(stderr, "   Der Port %u konnte nicht geöffnet werden.\r\n", settings->port);
+                fflush(stderr);
+                palette_destroy(palette);
+                return EXIT_FAILURE;
+        }
+
+        // SIGINT und SIGTERM werden nur vom Hauptthread mit sigwait angenommen. Die
+        // Maske wird vor dem Start der Threads gesetzt und von ihnen geerbt
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+        struct server *server = calloc(1, sizeof(*server));
+        unsigned connection_count = settings->connections > 0 ? settings->connections : 1;
+        struct connection *connections = calloc(connection_count, sizeof(*connections));
+        threadpool *pool = threadpool_create(options->threads);
+        _Bool allocated = server != NULL && connections != NULL && pool != NULL;
+        if (allocated)
+        {
+                *server = (struct server){
+                    .options = options,
+                    .settings = settings,
+                    .kernel = kernel,
+                    .palette = palette,
+                    .colors = colors,
+                    .color_count = color_count,
+                    .listener = listener,
+                    .pool = pool,
+                };
+                pthread_mutex_init(&server->render_lock, NULL);
+                pthread_mutex_init(&server->lock, NULL);
+                pthread_cond_init(&server->finished, NULL);
+
+                // Bereits berechnete Kacheln werden wie bei einzelnen Bildern aus der
+                // Datei übernommen
+                if (options->cache_path != NULL)
+                {
+                        server->cache = tile_cache_open(options->cache_path, options->cache_size,
+                                                        options->tile_size * options->tile_size);
+                        if (server->cache == NULL)
+                        {
+                                fprintf(stderr, "   Der Kachel-Cache %s konnte nicht geöffnet werden.\r\n", options->cache_path);
+                                fflush(stderr);
+                        }
+                }
+                for (unsigned c = 0; c < connection_count && allocated; c++)
+                {
+                        connections[c].server = server;
+                        connections[c].counts = malloc(SERVER_TILE_SIZE * SERVER_TILE_SIZE * sizeof(uint16_t));
+                        connections[c].started = connections[c].counts != NULL &&
+                                                 !pthread_create(&connections[c].thread, NULL, connection_main, &connections[c]);
+                        allocated = connections[c].started;
+                }
+        }
+
+        if (allocated)
+        {
+                printf("   Kachelserver läuft auf http://127.0.0.1:%u/{z}/{x}/{y}.png (%u Verbindungen, %u Threads, Kernel %s).\r\n",
+                       settings->port, connection_count, options->threads, kernel_name(kernel));
+                printf("   Kennzahlen unter http://127.0.0.1:%u/stats, Beenden mit Strg+C.\r\n", settings->port);
+                fflush(stdout);
+                int signal;
+                sigwait(&signals, &signal);
+        }
+        else
+        {
+                fprintf(stderr, "   Es konnte nicht genug Speicherplatz allokiert werden.\r\n");
+                fflush(stderr);
+        }
+
+        // Das Schließen des Sockets weckt alle Threads in accept. Laufende Anfragen
+        // werden noch beantwortet
+        if (server != NULL)
+                __atomic_store_n(&server->stopping, 1, __ATOMIC_RELEASE);
+        shutdown(listener, SHUT_RDWR);
+        for (unsigned c = 0; connections != NULL && c < connection_count; c++)
+        {
+                if (connections[c].started)
+                        pthread_join(connections[c].thread, NULL);
+                free(connections[c].counts);
+        }
+        close(listener);
+
+        if (allocated)
+        {
+                char stats[1024];
+                format_stats(server, "   ", stats, sizeof(stats));
+                printf("\r\n   Kachelserver beendet.\r\n%s", stats);
+                fflush(stdout);
+        }
+        if (server != NULL && server->pool != NULL)
+        {
+                tile_cache_close(server->cache);
+                while (server->oldest != NULL)
+                        cache_evict(server);
+                pthread_mutex_destroy(&server->render_lock);
+                pthread_mutex_destroy(&server->lock);
+                pthread_cond_destroy(&server->finished);
+        }
+        free(server);
+        free(connections);
+        threadpool_destroy(pool);
+        palette_destroy(palette);
+        return allocated ? EXIT_SUCCESS : EXIT_FAILURE;
+}
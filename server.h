@@ -0,0 +1,30 @@
+// Include Guards
+#ifndef SERVER_H
+#define SERVER_H
+#include "render.h"
+
+// Kantenlänge einer Kachel in Pixeln, wie bei Kartendiensten üblich
+#define SERVER_TILE_SIZE 256
+
+// Tiefste Zoomstufe. Auf Stufe z ist die Ebene in 2^z x 2^z Kacheln aufgeteilt
+#define SERVER_MAX_ZOOM 60
+
+// Einstellungen des Kachelservers
+typedef struct
+{
+        unsigned port;          // TCP Port auf 127.0.0.1
+        unsigned connections;   // Threads, die gleichzeitig Verbindungen bearbeiten
+        uint64_t memory_size;   // Maximale Größe der kodierten Kacheln im Speicher in Byte
+        int16_t max_iterations; // Maximale Iterationen jeder Kachel
+} server_settings;
+
+// serve: Beantwortet HTTP Anfragen der Form GET /{z}/{x}/{y}.png auf 127.0.0.1 mit
+// PNG Kacheln der Größe SERVER_TILE_SIZE, bis SIGINT oder SIGTERM eintrifft. Kachel
+// 0/0/0 zeigt das Quadrat [-2.5;1.5] x [-2;2], y zählt von oben nach unten. Die
+// Verbindungen teilen sich den Threadpool, gleichzeitige Anfragen derselben Kachel
+// werden nur einmal berechnet und kodierte Kacheln in einem LRU Cache gehalten.
+// GET /stats liefert Trefferquote und Latenzen. Gibt EXIT_SUCCESS oder EXIT_FAILURE
+// zurück
+int serve(const render_options *options, const server_settings *settings);
+
+#endif // !SERVER_H
@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+// Warteschlange eines Workers. Enthält den noch nicht abgearbeiteten
+// Indexbereich [begin;end). Der Besitzer entnimmt von vorne, Diebe
+// stehlen die hintere Hälfte
+struct worker_queue
+{
+        pthread_mutex_t lock;
+        size_t begin;
+        size_t end;
+};
+
+struct threadpool
+{
+        unsigned threads;
+        pthread_t *handles;
+        struct worker_queue *queues;
+
+        // Synchronisation zwischen threadpool_run und den Workern
+        pthread_mutex_t lock;
+        pthread_cond_t start;
+        pthread_cond_t done;
+        unsigned long generation;
+        unsigned active;
+        _Bool shutdown;
+
+        // Serialisiert gleichzeitige Aufrufe von threadpool_run
+        pthread_mutex_t run_lock;
+
+        // Aufgabe des aktuellen Durchlaufs
+        task_fn fn;
+        void *ctx;
+};
+
+// Argument für den Startpunkt eines Worker Threads
+struct worker_arg
+{
+        threadpool *pool;
+        unsigned id;
+};
+
+// steal: Versucht die hintere Hälfte des Bereichs eines anderen Workers in die
+// eigene Warteschlange zu übernehmen. Gibt 0 zurück, wenn alle Warteschlangen
+// leer sind
+static _Bool steal(threadpool *pool, unsigned id)
+{
+        for (unsigned i = 1; i < pool->threads; i++)
+        {
+                struct worker_queue *victim = &pool->queues[(id + i) % pool->threads];
+                pthread_mutex_lock(&victim->lock);
+                size_t remaining = victim->end - victim->begin;
+                if (remaining == 0)
+                {
+                        pthread_mutex_unlock(&victim->lock);
+                        continue;
+                }
+                size_t half = (remaining + 1) / 2;
+                size_t end = victim->end;
+                victim->end -= half;
+                pthread_mutex_unlock(&victim->lock);
+
+                struct worker_queue *own = &pool->queues[id];
+                pthread_mutex_lock(&own->lock);
+                own->begin = end - half;
+                own->end = end;
+                pthread_mutex_unlock(&own->lock);
+                return 1;
+        }
+        return 0;
+}
+
+// work: Arbeitet die eigene Warteschlange ab und stiehlt anschließend so lange
+// von anderen Workern, bis keine Aufgaben mehr vorhanden sind
+static void work(threadpool *pool, unsigned id)
+{
+        struct worker_queue *own = &pool->queues[id];
+        for (;;)
+        {
+                pthread_mutex_lock(&own->lock);
+                if (own->begin < own->end)
+                {
+                        size_t index = own->begin++;
+                        pthread_mutex_unlock(&own->lock);
+                        pool->fn(pool->ctx, index, id);
+                        continue;
+                }
+                pthread_mutex_unlock(&own->lock);
+
+                if (!steal(pool, id))
+                        return;
+        }
+}
+
+// Startpunkt der Worker Threads: Wartet auf einen neuen Durchlauf, arbeitet
+// diesen ab und meldet den Abschluss
+static void *worker_main(void *arg)
+{
+        threadpool *pool = ((struct worker_arg *)arg)->pool;
+        unsigned id = ((struct worker_arg *)arg)->id;
+        free(arg);
+
+        unsigned long seen = 0;
+        for (;;)
+        {
+                pthread_mutex_lock(&pool->lock);
+                while (!pool->shutdown && pool->generation == seen)
+                        pthread_cond_wait(&pool->start, &pool->lock);
+                if (pool->shutdown)
+                {
+                        pthread_mutex_unlock(&pool->lock);
+                        return NULL;
+                }
+                seen = pool->generation;
+                pthread_mutex_unlock(&pool->lock);
+
+                work(pool, id);
+
+                pthread_mutex_lock(&pool->lock);
+                if (--pool->active == 0)
+                        pthread_cond_signal(&pool->done);
+                pthread_mutex_unlock(&pool->lock);
+        }
+}
+
+unsigned threadpool_default_threads(void)
+{
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        return cpus > 0 ? (unsigned)cpus : 1;
+}
+
+threadpool *threadpool_create(unsigned threads)
+{
+        if (threads == 0)
+                threads = 1;
+
+        threadpool *pool = calloc(1, sizeof(*pool));
+        if (pool == NULL)
+                return NULL;
+        pool->threads = threads;
+        pool->queues = calloc(threads, sizeof(*pool->queues));
+        pool->handles = calloc(threads, sizeof(*pool->handles));
+        if (pool->queues == NULL || pool->handles == NULL)
+        {
+                free(pool->queues);
+                free(pool->handles);
+                free(pool);
+                return NULL;
+        }
+
+        for (unsigned i = 0; i < threads; i++)
+                pthread_mutex_init(&pool->queues[i].lock, NULL);
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_mutex_init(&pool->run_lock, NULL);
+        pthread_cond_init(&pool->start, NULL);
+        pthread_cond_init(&pool->done, NULL);
+
+        // Worker 0 ist der Aufrufer von threadpool_run, daher werden nur
+        // threads - 1 zusätzliche Threads gestartet. Schlägt das Starten fehl,
+        // wird mit den bereits laufenden Threads weitergearbeitet
+        for (unsigned i = 1; i < threads; i++)
+        {
+                struct worker_arg *arg = malloc(sizeof(*arg));
+                if (arg == NULL)
+                {
+                        pool->threads = i;
+                        break;
+                }
+                arg->pool = pool;
+                arg->id = i;
+                if (pthread_create(&pool->handles[i], NULL, worker_main, arg))
+                {
+                        free(arg);
+                        pool->threads = i;
+                        break;
+                }
+        }
+        return pool;
+}
+
+void threadpool_run(threadpool *pool, size_t count, task_fn fn, void *ctx)
+{
+        pthread_mutex_lock(&pool->run_lock);
+        pool->fn = fn;
+        pool->ctx = ctx;
+
+        // Zusammenhängende Blöcke verteilen, damit benachbarte Kacheln
+        // möglichst vom selben Worker berechnet werden
+        for (unsigned i = 0; i < pool->threads; i++)
+        {
+                pthread_mutex_lock(&pool->queues[i].lock);
+                pool->queues[i].begin = count * i / pool->threads;
+                pool->queues[i].end = count * (i + 1) / pool->threads;
+                pthread_mutex_unlock(&pool->queues[i].lock);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        pool->active = pool->threads - 1;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+
+        work(pool, 0);
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->active > 0)
+                pthread_cond_wait(&pool->done, &pool->lock);
+        pthread_mutex_unlock(&pool->lock);
+        pthread_mutex_unlock(&pool->run_lock);
+}
+
+unsigned threadpool_size(const threadpool *pool)
+{
+        return pool->threads;
+}
+
+void threadpool_destroy(threadpool *pool)
+{
+        if (pool == NULL)
+                return;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->shutdown = 1;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (unsigned i = 1; i < pool->threads; i++)
+                pthread_join(pool->handles[i], NULL);
+
+        for (unsigned i = 0; i < pool->threads; i++)
+                pthread_mutex_destroy(&pool->queues[i].lock);
+        pthread_mutex_destroy(&pool->lock);
+        pthread_mutex_destroy(&pool->run_lock);
+        pthread_cond_destroy(&pool->start);
+        pthread_cond_destroy(&pool->done);
+        free(pool->queues);
+        free(pool->handles);
+        free(pool);
+}
@@ -0,0 +1,33 @@
+// Include Guards
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <stddef.h>
+
+// Aufgabenfunktion eines Threadpools. Erhält den vom Aufrufer übergebenen
+// Kontext, den Index der Aufgabe und den Index des ausführenden Workers
+typedef void (*task_fn)(void *ctx, size_t index, unsigned worker);
+
+// Undurchsichtiger Typ des Threadpools (s. threadpool.c)
+typedef struct threadpool threadpool;
+
+// threadpool_create: Erstellt einen Pool mit insgesamt `threads` Workern. Der
+// aufrufende Thread zählt als Worker 0, es werden also threads - 1 Threads
+// gestartet. Gibt NULL zurück, falls der Pool nicht erstellt werden konnte
+threadpool *threadpool_create(unsigned threads);
+
+// threadpool_run: Führt fn für alle Indizes 0 bis count - 1 aus und kehrt erst
+// zurück, wenn alle Aufgaben abgeschlossen sind. Die Indizes werden in
+// zusammenhängenden Blöcken auf die Worker verteilt; hat ein Worker seinen Block
+// abgearbeitet, stiehlt er die hintere Hälfte des Blockes eines anderen Workers
+void threadpool_run(threadpool *pool, size_t count, task_fn fn, void *ctx);
+
+// threadpool_size: Gibt die Anzahl der Worker inklusive des Aufrufers zurück
+unsigned threadpool_size(const threadpool *pool);
+
+// threadpool_destroy: Beendet alle Worker und gibt den Pool frei
+void threadpool_destroy(threadpool *pool);
+
+// threadpool_default_threads: Anzahl der online verfügbaren Prozessorkerne
+unsigned threadpool_default_threads(void);
+
+#endif // !THREADPOOL_H
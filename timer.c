@@ -0,0 +1,11 @@
+#include <time.h>
+#include "timer.h"
+
+// Methode zur Rückgabe der aktuellen Zeit. Die Nanosekunden werden in double
+// umgerechnet, da ein float nur auf etwa eine Millisekunde genau wäre
+double curtime(void)
+{
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return t.tv_sec + t.tv_nsec * 1e-9;
+}
@@ -0,0 +1,8 @@
+// Include Guards
+#ifndef TIMER_H
+#define TIMER_H
+
+// curtime: Gibt die aktuelle Zeit der monotonen Uhr in Sekunden zurück
+double curtime(void);
+
+#endif // !TIMER_H
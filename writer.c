@@ -0,0 +1,669 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "bmp.h"
+#include "writer.h"
+
+// Namen und Dateiendungen der Formate in der Reihenfolge von image_format
+static const char *const format_names[] = {"auto", "bmp", "bigtiff", "bmp8", "rle8", "png"};
+static const char *const format_extensions[] = {"", ".bmp", ".tif", ".bmp", ".bmp", ".png"};
+
+// TIFF Feldtypen
+#define TIFF_SHORT 3
+#define TIFF_LONG 4
+#define TIFF_LONG8 16
+
+// Größe des BigTIFF Headers, danach beginnen die Pixeldaten
+#define BIGTIFF_HEADER_SIZE 16
+
+// Anzahl der Einträge des BigTIFF IFD
+#define BIGTIFF_ENTRIES 10
+
+// Komprimierungsart BI_RLE8 im BITMAPINFOHEADER
+#define BMP_RLE8 1
+
+// Unkomprimierte Größe eines unabhängig komprimierten PNG Blocks. Kleinere Blöcke
+// verteilen sich besser auf die Worker, größere komprimieren etwas besser
+#define PNG_BLOCK_SIZE (256 * 1024)
+
+// BMP, BMP8 und BigTIFF Dateien werden beim Öffnen auf ihre endgültige Größe
+// gebracht und vollständig in den Speicher abgebildet. Die Header werden sofort
+// geschrieben, die Pixel direkt in die abgebildeten Zeilen. Das Zurückschreiben
+// übernimmt der Page Cache. Die Größe von RLE8 und PNG Dateien steht erst nach dem
+// Kodieren fest, ihre Zeilen werden daher in einem Puffer gesammelt und fortlaufend
+// geschrieben
+struct image_writer
+{
+        image_format format;
+        uint64_t width;
+        uint64_t height;
+        uint64_t rows_per_strip;
+        uint64_t rows_written;
+        size_t row_size;    // Pixelbytes einer Zeile ohne Auffüllung
+        size_t padding;     // Auffüllung einer BMP Zeile auf 4 Byte
+        const uint32_t *colors;
+        unsigned color_count;
+        threadpool *pool;
+
+        // Abgebildete Formate
+        int fd;
+        unsigned char *map;
+        size_t size;
+        size_t data_offset; // Offset der ersten Pixelzeile in der Datei
+
+        // Fortlaufend geschriebene Formate. Der Puffer enthält die Zeilen des letzten
+        // Aufrufs von image_writer_rows in der Reihenfolge der Datei. PNG Zeilen
+        // beginnen mit dem Byte für den Filtertyp
+        FILE *fp;
+        unsigned char *buffer;
+        uint64_t buffer_rows;  // Anzahl der Zeilen, für die der Puffer reicht
+        uint64_t pending;      // Anzahl der noch nicht kodierten Zeilen
+        size_t buffer_stride;  // Abstand zweier Zeilen im Puffer
+        uint64_t encoded_size; // RLE8: Größe der bisher kodierten Pixeldaten
+        uLong adler;           // PNG: Adler-32 Prüfsumme der unkomprimierten Daten
+};
+
+// Ein unabhängig komprimierter Teil der Zeilen einer PNG Datei
+struct png_block
+{
+        const unsigned char *input;
+        size_t input_size;
+        unsigned char *output;
+        size_t output_size;
+        uLong adler;
+        _Bool last;
+        _Bool failed;
+};
+
+_Bool image_format_parse(const char *name, image_format *format)
+{
+        for (unsigned i = 0; i < sizeof(format_names) / sizeof(*format_names); i++)
+        {
+                if (!strcmp(name, format_names[i]))
+                {
+                        *format = (image_format)i;
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+// bmp_fits: Bitmap Dateien speichern Breite und Höhe als int32 und die
+// Dateigröße als uint32. Mit einem Byte pro Pixel folgt den Headern eine
+// Farbtabelle mit bis zu 256 Einträgen
+static _Bool bmp_fits(uint64_t width, uint64_t height, size_t pixel_size)
+{
+        if (width > INT32_MAX || height > INT32_MAX)
+                return 0;
+        uint64_t row = (width * pixel_size + 3) & ~(uint64_t)3;
+        uint64_t headers = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + (pixel_size == 1 ? 256 * sizeof(uint32_t) : 0);
+        return row * height <= UINT32_MAX - headers;
+}
+
+image_format image_format_resolve(image_format format, uint64_t width, uint64_t height)
+{
+        switch (format)
+        {
+        case IMAGE_FORMAT_AUTO:
+                return bmp_fits(width, height, sizeof(RGBTRIPLET)) ? IMAGE_FORMAT_BMP : IMAGE_FORMAT_BIGTIFF;
+        case IMAGE_FORMAT_BMP:
+                return bmp_fits(width, height, sizeof(RGBTRIPLET)) ? IMAGE_FORMAT_BMP : IMAGE_FORMAT_AUTO;
+        case IMAGE_FORMAT_BMP8:
+                return bmp_fits(width, height, 1) ? IMAGE_FORMAT_BMP8 : IMAGE_FORMAT_AUTO;
+        case IMAGE_FORMAT_RLE8:
+        case IMAGE_FORMAT_PNG:
+                // Die Größe einer RLE8 Datei wird erst beim Schließen geprüft
+                return width <= INT32_MAX && height <= INT32_MAX ? format : IMAGE_FORMAT_AUTO;
+        default:
+                return width <= UINT32_MAX && height <= UINT32_MAX ? format : IMAGE_FORMAT_AUTO;
+        }
+}
+
+const char *image_format_extension(image_format format)
+{
+        return format_extensions[format];
+}
+
+_Bool image_format_rgb(image_format format)
+{
+        return format == IMAGE_FORMAT_BIGTIFF || format == IMAGE_FORMAT_PNG;
+}
+
+_Bool image_format_indexed(image_format format)
+{
+        return format == IMAGE_FORMAT_BMP8 || format == IMAGE_FORMAT_RLE8 || format == IMAGE_FORMAT_PNG;
+}
+
+// streamed: Gibt an, ob das Format fortlaufend statt über eine Abbildung geschrieben wird
+static _Bool streamed(image_format format)
+{
+        return format == IMAGE_FORMAT_RLE8 || format == IMAGE_FORMAT_PNG;
+}
+
+// bmp_header_size: Größe der Header einer Bitmap Datei inklusive Farbtabelle
+static size_t bmp_header_size(const image_writer *writer)
+{
+        size_t colors = image_format_indexed(writer->format) ? writer->color_count : 0;
+        return sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + colors * sizeof(uint32_t);
+}
+
+// Schreibt die Header einer Bitmap Datei mit 24 oder 8 Bit pro Pixel und
+// gegebenenfalls die Farbtabelle nach out. Die Einträge der Tabelle haben bereits
+// das Format Blau, Grün, Rot, 0
+static void bmp_write_header(const image_writer *writer, unsigned char *out, uint32_t imageSize)
+{
+        BITMAPFILEHEADER bmFH;
+        BITMAPINFOHEADER bmIH;
+        _Bool indexed = image_format_indexed(writer->format);
+        uint32_t headerSize = bmp_header_size(writer);
+
+        bmFH.bfType = 0x4d42;
+        bmFH.bfSize = headerSize + imageSize;
+        bmFH.bfReserved1 = 0;
+        bmFH.bfReserved2 = 0;
+        bmFH.bfOffBits = headerSize;
+
+        bmIH.biSize = sizeof(bmIH);
+        bmIH.biWidth = writer->width;
+        bmIH.biHeight = writer->height;
+        bmIH.biPlanes = 1;
+        bmIH.biBitCount = indexed ? 8 : 24;
+        bmIH.biCompression = writer->format == IMAGE_FORMAT_RLE8 ? BMP_RLE8 : 0;
+        bmIH.biSizeImage = imageSize;
+        bmIH.biXPelsPerMeter = 0;
+        bmIH.biYPelsPerMeter = 0;
+        bmIH.biClrUsed = indexed ? writer->color_count : 0;
+        bmIH.biClrImportant = 0;
+
+        memcpy(out, &bmFH, sizeof(bmFH));
+        memcpy(out + sizeof(bmFH), &bmIH, sizeof(bmIH));
+        if (indexed)
+                memcpy(out + sizeof(bmFH) + sizeof(bmIH), writer->colors, writer->color_count * sizeof(uint32_t));
+}
+
+// bigtiff_layout: Berechnet die Anzahl der Strips, die Offsets der Tabellen und des
+// IFD und gibt die Größe der Datei zurück. Hinter den lückenlos abgelegten Strips
+// folgen, auf 8 Byte ausgerichtet, die Tabellen der Strip Offsets und Größen (nur
+// bei mehr als einem Strip) und der IFD
+static uint64_t bigtiff_layout(const image_writer *writer, uint64_t *strips, uint64_t *tables, uint64_t *ifd_offset)
+{
+        *strips = (writer->height + writer->rows_per_strip - 1) / writer->rows_per_strip;
+        *tables = (BIGTIFF_HEADER_SIZE + writer->height * writer->row_size + 7) / 8 * 8;
+        *ifd_offset = *tables + (*strips > 1 ? 2 * *strips * sizeof(uint64_t) : 0);
+        return *ifd_offset + sizeof(uint64_t) + BIGTIFF_ENTRIES * 20 + sizeof(uint64_t);
+}
+
+// Schreibt size Byte an die Stelle *position der Datei und rückt *position weiter
+static void put(image_writer *writer, uint64_t *position, const void *value, size_t size)
+{
+        memcpy(writer->map + *position, value, size);
+        *position += size;
+}
+
+// Schreibt einen IFD Eintrag. Passt der Wert in 8 Byte, steht er direkt im
+// Eintrag, sonst ist value der Offset der Werte in der Datei
+static void bigtiff_put_entry(image_writer *writer, uint64_t *position, uint16_t tag, uint16_t type, uint64_t count,
+                              uint64_t value)
+{
+        put(writer, position, &tag, sizeof(tag));
+        put(writer, position, &type, sizeof(type));
+        put(writer, position, &count, sizeof(count));
+        put(writer, position, &value, sizeof(value));
+}
+
+// Schreibt den BigTIFF Header (Byte Order "II", Version 43, Offsetgröße 8, Offset
+// des IFD), die Tabellen der Strip Offsets und Größen und den IFD
+static void bigtiff_write_header(image_writer *writer)
+{
+        uint64_t rows_per_strip = writer->rows_per_strip;
+        uint64_t strips, tables, ifd_offset;
+        bigtiff_layout(writer, &strips, &tables, &ifd_offset);
+        uint64_t strip_size = rows_per_strip * writer->row_size;
+        uint64_t last_size = (writer->height - (strips - 1) * rows_per_strip) * writer->row_size;
+
+        uint64_t position = 0;
+        uint16_t header[4] = {0x4949, 43, 8, 0};
+        put(writer, &position, header, sizeof(header));
+        put(writer, &position, &ifd_offset, sizeof(ifd_offset));
+
+        uint64_t offsets = BIGTIFF_HEADER_SIZE;
+        uint64_t sizes = last_size;
+        if (strips > 1)
+        {
+                position = offsets = tables;
+                for (uint64_t i = 0; i < strips; i++)
+                {
+                        uint64_t offset = BIGTIFF_HEADER_SIZE + i * strip_size;
+                        put(writer, &position, &offset, sizeof(offset));
+                }
+                sizes = position;
+                for (uint64_t i = 0; i < strips; i++)
+                {
+                        uint64_t size = i + 1 < strips ? strip_size : last_size;
+                        put(writer, &position, &size, sizeof(size));
+                }
+        }
+
+        position = ifd_offset;
+        uint64_t entries = BIGTIFF_ENTRIES;
+        put(writer, &position, &entries, sizeof(entries));
+        bigtiff_put_entry(writer, &position, 256, TIFF_LONG, 1, writer->width);                // ImageWidth
+        bigtiff_put_entry(writer, &position, 257, TIFF_LONG, 1, writer->height);               // ImageLength
+        bigtiff_put_entry(writer, &position, 258, TIFF_SHORT, 3, 8 | 8 << 16 | (uint64_t)8 << 32); // BitsPerSample
+        bigtiff_put_entry(writer, &position, 259, TIFF_SHORT, 1, 1);                           // Compression: keine
+        bigtiff_put_entry(writer, &position, 262, TIFF_SHORT, 1, 2);                           // Photometric: RGB
+        bigtiff_put_entry(writer, &position, 273, TIFF_LONG8, strips, offsets);                // StripOffsets
+        bigtiff_put_entry(writer, &position, 277, TIFF_SHORT, 1, 3);                           // SamplesPerPixel
+        bigtiff_put_entry(writer, &position, 278, TIFF_LONG, 1, rows_per_strip);               // RowsPerStrip
+        bigtiff_put_entry(writer, &position, 279, TIFF_LONG8, strips, sizes);                  // StripByteCounts
+        bigtiff_put_entry(writer, &position, 284, TIFF_SHORT, 1, 1);                           // PlanarConfiguration
+        uint64_t next_ifd = 0;
+        put(writer, &position, &next_ifd, sizeof(next_ifd));
+}
+
+// rle8_encode_row: Kodiert eine Zeile nach BI_RLE8 und schreibt sie. Folgen von
+// mindestens drei gleichen Pixeln werden als Paar aus Anzahl und Index gespeichert,
+// dazwischenliegende Pixel im absoluten Modus. Die Zeile endet mit 0x00 0x00
+static _Bool rle8_encode_row(image_writer *writer, const unsigned char *row, unsigned char *out)
+{
+        size_t size = 0;
+        uint64_t i = 0;
+        while (i < writer->width)
+        {
+                uint64_t run = 1;
+                while (i + run < writer->width && run < 255 && row[i + run] == row[i])
+                        run++;
+                if (run >= 3)
+                {
+                        out[size++] = (unsigned char)run;
+                        out[size++] = row[i];
+                        i += run;
+                        continue;
+                }
+
+                // Pixel bis zur nächsten Folge von drei gleichen Pixeln sammeln
+                uint64_t literal = 0;
+                while (i + literal < writer->width && literal < 255)
+                {
+                        uint64_t j = i + literal;
+                        if (j + 2 < writer->width && row[j] == row[j + 1] && row[j] == row[j + 2])
+                                break;
+                        literal++;
+                }
+
+                // Der absolute Modus benötigt mindestens drei Pixel und wird auf eine
+                // gerade Anzahl an Byte aufgefüllt
+                if (literal < 3)
+                {
+                        for (uint64_t k = 0; k < literal; k++)
+                        {
+                                out[size++] = 1;
+                                out[size++] = row[i + k];
+                        }
+                }
+                else
+                {
+                        out[size++] = 0;
+                        out[size++] = (unsigned char)literal;
+                        memcpy(out + size, row + i, literal);
+                        size += literal;
+                        if (literal & 1)
+                                out[size++] = 0;
+                }
+                i += literal;
+        }
+        out[size++] = 0;
+        out[size++] = 0;
+        writer->encoded_size += size;
+        return fwrite(out, 1, size, writer->fp) == size;
+}
+
+// png_write_chunk: Schreibt einen PNG Chunk aus Länge, Typ, Daten und CRC-32
+static _Bool png_write_chunk(image_writer *writer, const char *type, const unsigned char *data, size_t size)
+{
+        unsigned char length[4] = {size >> 24, size >> 16, size >> 8, size};
+        uLong crc = crc32(0, (const Bytef *)type, 4);
+        if (size > 0)
+                crc = crc32(crc, data, (uInt)size);
+        unsigned char check[4] = {crc >> 24, crc >> 16, crc >> 8, crc};
+        return fwrite(length, 1, 4, writer->fp) == 4 && fwrite(type, 1, 4, writer->fp) == 4 &&
+               (size == 0 || fwrite(data, 1, size, writer->fp) == size) && fwrite(check, 1, 4, writer->fp) == 4;
+}
+
+// png_write_header: Schreibt Signatur, IHDR (8 Bit Farbindizes), die Farbtabelle
+// als PLTE und den Header des zlib Datenstroms als erstes IDAT
+static _Bool png_write_header(image_writer *writer)
+{
+        static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        uint32_t width = (uint32_t)writer->width;
+        uint32_t height = (uint32_t)writer->height;
+        unsigned char header[13] = {width >> 24, width >> 16, width >> 8, width,
+                                    height >> 24, height >> 16, height >> 8, height,
+                                    8, 3, 0, 0, 0};
+        unsigned char palette[256 * 3];
+        for (unsigned i = 0; i < writer->color_count; i++)
+                memcpy(palette + i * 3, &writer->colors[i], 3);
+        static const unsigned char zlib_header[2] = {0x78, 0x9c};
+
+        return fwrite(signature, 1, sizeof(signature), writer->fp) == sizeof(signature) &&
+               png_write_chunk(writer, "IHDR", header, sizeof(header)) &&
+               png_write_chunk(writer, "PLTE", palette, writer->color_count * 3) &&
+               png_write_chunk(writer, "IDAT", zlib_header, sizeof(zlib_header));
+}
+
+// png_deflate_block: Aufgabe des Threadpools. Komprimiert einen Block als rohen
+// Deflate Datenstrom. Alle Blöcke außer dem letzten enden mit einem Sync Flush auf
+// einer Bytegrenze, sodass ihre Ausgaben aneinandergehängt einen gültigen
+// Datenstrom ergeben
+static void png_deflate_block(void *ctx, size_t index, unsigned worker)
+{
+        (void)worker;
+        struct png_block *block = &((struct png_block *)ctx)[index];
+        block->adler = adler32(1, block->input, (uInt)block->input_size);
+
+        z_stream stream = {0};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+                block->failed = 1;
+                return;
+        }
+        stream.next_in = (Bytef *)block->input;
+        stream.avail_in = (uInt)block->input_size;
+        stream.next_out = block->output;
+        stream.avail_out = (uInt)block->output_size;
+        int result = deflate(&stream, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+        block->failed = stream.avail_in != 0 || (block->last ? result != Z_STREAM_END : result != Z_OK);
+        block->output_size -= stream.avail_out;
+        deflateEnd(&stream);
+}
+
+// png_encode: Komprimiert die Zeilen im Puffer in Blöcken parallel und schreibt sie
+// als IDAT Chunks. Die Prüfsummen der Blöcke werden zur Prüfsumme des Datenstroms
+// zusammengesetzt
+static _Bool png_encode(image_writer *writer)
+{
+        size_t block_rows = PNG_BLOCK_SIZE / writer->buffer_stride > 0 ? PNG_BLOCK_SIZE / writer->buffer_stride : 1;
+        size_t count = (writer->pending + block_rows - 1) / block_rows;
+        size_t bound = compressBound((uLong)(block_rows * writer->buffer_stride)) + 64;
+        struct png_block *blocks = calloc(count, sizeof(*blocks));
+        unsigned char *output = malloc(count * bound);
+        if (blocks == NULL || output == NULL)
+        {
+                free(blocks);
+                free(output);
+                return 0;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+                size_t rows = writer->pending - i * block_rows < block_rows ? writer->pending - i * block_rows : block_rows;
+                blocks[i] = (struct png_block){
+                    .input = writer->buffer + i * block_rows * writer->buffer_stride,
+                    .input_size = rows * writer->buffer_stride,
+                    .output = output + i * bound,
+                    .output_size = bound,
+                    .last = i + 1 == count && writer->rows_written == writer->height,
+                };
+        }
+        if (writer->pool != NULL)
+                threadpool_run(writer->pool, count, png_deflate_block, blocks);
+        else
+                for (size_t i = 0; i < count; i++)
+                        png_deflate_block(blocks, i, 0);
+
+        _Bool success = 1;
+        for (size_t i = 0; i < count && success; i++)
+        {
+                success = !blocks[i].failed && png_write_chunk(writer, "IDAT", blocks[i].output, blocks[i].output_size);
+                writer->adler = adler32_combine(writer->adler, blocks[i].adler, (z_off_t)blocks[i].input_size);
+        }
+        free(blocks);
+        free(output);
+        return success;
+}
+
+// encode_pending: Kodiert die zuletzt angeforderten Zeilen fortlaufend geschriebener
+// Formate. Gibt 0 zurück, falls das Kodieren oder Schreiben fehlgeschlagen ist
+static _Bool encode_pending(image_writer *writer)
+{
+        if (writer->pending == 0)
+                return 1;
+
+        _Bool success = 1;
+        if (writer->format == IMAGE_FORMAT_PNG)
+        {
+                success = png_encode(writer);
+        }
+        else
+        {
+                // Im ungünstigsten Fall belegt jedes Pixel zwei Byte
+                unsigned char *out = malloc(2 * writer->width + 2);
+                success = out != NULL;
+                for (uint64_t row = 0; row < writer->pending && success; row++)
+                        success = rle8_encode_row(writer, writer->buffer + row * writer->buffer_stride, out);
+                free(out);
+        }
+        writer->pending = 0;
+        return success;
+}
+
+// writer_create: Legt einen Writer mit den Angaben an, die alle Formate teilen. Gibt
+// NULL zurück, falls kein Speicher verfügbar ist oder einem indizierten Format die
+// Farbtabelle fehlt
+static image_writer *writer_create(image_format format, uint64_t width, uint64_t height,
+                                   const image_writer_settings *settings)
+{
+        image_writer *writer = calloc(1, sizeof(*writer));
+        if (writer == NULL)
+                return NULL;
+        uint64_t rows_per_strip = settings->rows_per_strip;
+        writer->format = format;
+        writer->width = width;
+        writer->height = height;
+        writer->rows_per_strip = rows_per_strip == 0 || rows_per_strip > height ? height : rows_per_strip;
+        writer->row_size = width * (image_format_indexed(format) ? 1 : sizeof(RGBTRIPLET));
+        writer->padding = format == IMAGE_FORMAT_BMP || format == IMAGE_FORMAT_BMP8 ? (4 - writer->row_size % 4) % 4 : 0;
+        writer->colors = settings->colors;
+        writer->color_count = settings->color_count;
+        writer->pool = settings->pool;
+        writer->fd = -1;
+        if (image_format_indexed(format) && (writer->colors == NULL || writer->color_count == 0 || writer->color_count > 256))
+        {
+                free(writer);
+                return NULL;
+        }
+        return writer;
+}
+
+// stream_start: Schreibt die Header eines fortlaufend geschriebenen Formats nach fp.
+// Gibt 0 zurück, falls das Schreiben fehlgeschlagen ist
+static _Bool stream_start(image_writer *writer, FILE *fp)
+{
+        writer->buffer_stride = writer->row_size + (writer->format == IMAGE_FORMAT_PNG);
+        writer->adler = adler32(0, NULL, 0);
+        writer->fp = fp;
+
+        // Der Header einer RLE8 Datei wird beim Schließen mit den endgültigen
+        // Größen erneut geschrieben
+        if (writer->format == IMAGE_FORMAT_PNG)
+                return png_write_header(writer);
+        unsigned char header[bmp_header_size(writer)];
+        bmp_write_header(writer, header, 0);
+        return fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+}
+
+image_writer *image_writer_open_stream(FILE *fp, image_format format, uint64_t width, uint64_t height,
+                                       const image_writer_settings *settings)
+{
+        if (!streamed(format))
+                return NULL;
+        image_writer *writer = writer_create(format, width, height, settings);
+        if (writer != NULL && !stream_start(writer, fp))
+        {
+                free(writer);
+                return NULL;
+        }
+        return writer;
+}
+
+image_writer *image_writer_open(const char *path, image_format format, uint64_t width, uint64_t height,
+                                const image_writer_settings *settings)
+{
+        image_writer *writer = writer_create(format, width, height, settings);
+        if (writer == NULL)
+                return NULL;
+
+        if (streamed(format))
+        {
+                FILE *fp = fopen(path, "wb");
+                if (fp == NULL)
+                {
+                        free(writer);
+                        return NULL;
+                }
+                if (!stream_start(writer, fp))
+                {
+                        fclose(fp);
+                        free(writer);
+                        return NULL;
+                }
+                return writer;
+        }
+
+        uint64_t strips, tables, ifd_offset;
+        if (format == IMAGE_FORMAT_BIGTIFF)
+        {
+                writer->data_offset = BIGTIFF_HEADER_SIZE;
+                writer->size = bigtiff_layout(writer, &strips, &tables, &ifd_offset);
+        }
+        else
+        {
+                writer->data_offset = bmp_header_size(writer);
+                writer->size = writer->data_offset + (writer->row_size + writer->padding) * height;
+        }
+
+        // Der Speicherplatz wird vorab reserviert, damit ein volles Dateisystem beim
+        // Öffnen erkannt wird und nicht erst beim Schreiben in die Abbildung
+        writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (writer->fd < 0)
+        {
+                free(writer);
+                return NULL;
+        }
+        if (posix_fallocate(writer->fd, 0, (off_t)writer->size) ||
+            (writer->map = mmap(NULL, writer->size, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, 0)) == MAP_FAILED)
+        {
+                close(writer->fd);
+                free(writer);
+                return NULL;
+        }
+
+        if (format == IMAGE_FORMAT_BIGTIFF)
+                bigtiff_write_header(writer);
+        else
+                bmp_write_header(writer, writer->map, (writer->row_size + writer->padding) * height);
+        return writer;
+}
+
+_Bool image_writer_bottom_up(const image_writer *writer)
+{
+        return writer->format != IMAGE_FORMAT_BIGTIFF && writer->format != IMAGE_FORMAT_PNG;
+}
+
+unsigned char *image_writer_rows(image_writer *writer, uint64_t y, uint64_t count, ptrdiff_t *stride)
+{
+        if (y > writer->height || count > writer->height - y)
+                return NULL;
+
+        // Fortlaufend geschriebene Zeilen landen im Puffer. Zuvor werden die Zeilen
+        // des letzten Aufrufs kodiert
+        if (streamed(writer->format))
+        {
+                _Bool bottom_up = image_writer_bottom_up(writer);
+                uint64_t first = bottom_up ? y : writer->height - y - count;
+                if (!encode_pending(writer) || first != writer->rows_written)
+                        return NULL;
+
+                if (count > writer->buffer_rows)
+                {
+                        unsigned char *buffer = realloc(writer->buffer, count * writer->buffer_stride);
+                        if (buffer == NULL)
+                                return NULL;
+                        writer->buffer = buffer;
+                        writer->buffer_rows = count;
+                }
+
+                // Filtertyp 0 (keiner) vor jeder PNG Zeile
+                size_t skip = writer->buffer_stride - writer->row_size;
+                for (uint64_t row = 0; row < count && skip; row++)
+                        writer->buffer[row * writer->buffer_stride] = 0;
+
+                writer->pending = count;
+                writer->rows_written += count;
+                if (bottom_up)
+                {
+                        *stride = (ptrdiff_t)writer->buffer_stride;
+                        return writer->buffer + skip;
+                }
+                *stride = -(ptrdiff_t)writer->buffer_stride;
+                return writer->buffer + (count - 1) * writer->buffer_stride + skip;
+        }
+
+        // BMP Dateien beginnen mit der untersten Zeile, TIFF Dateien mit der obersten
+        writer->rows_written += count;
+        size_t row_stride = writer->row_size + writer->padding;
+        if (image_writer_bottom_up(writer))
+        {
+                *stride = (ptrdiff_t)row_stride;
+                return writer->map + writer->data_offset + y * row_stride;
+        }
+        *stride = -(ptrdiff_t)row_stride;
+        return writer->map + writer->data_offset + (writer->height - 1 - y) * row_stride;
+}
+
+_Bool image_writer_close(image_writer *writer)
+{
+        _Bool success = writer->rows_written == writer->height;
+        if (!streamed(writer->format))
+        {
+                if (munmap(writer->map, writer->size))
+                        success = 0;
+                if (close(writer->fd))
+                        success = 0;
+                free(writer);
+                return success;
+        }
+
+        success = encode_pending(writer) && success;
+        if (success && writer->format == IMAGE_FORMAT_PNG)
+        {
+                // Die Prüfsumme beendet den zlib Datenstrom
+                uLong adler = writer->adler;
+                unsigned char trailer[4] = {adler >> 24, adler >> 16, adler >> 8, adler};
+                success = png_write_chunk(writer, "IDAT", trailer, sizeof(trailer)) &&
+                          png_write_chunk(writer, "IEND", NULL, 0);
+        }
+        else if (success)
+        {
+                // Ende der Bitmap und Header mit den endgültigen Größen
+                static const unsigned char end[2] = {0, 1};
+                writer->encoded_size += sizeof(end);
+                unsigned char header[bmp_header_size(writer)];
+                success = writer->encoded_size + sizeof(header) <= UINT32_MAX &&
+                          fwrite(end, 1, sizeof(end), writer->fp) == sizeof(end);
+                bmp_write_header(writer, header, (uint32_t)writer->encoded_size);
+                success = success && !fseeko(writer->fp, 0, SEEK_SET) &&
+                          fwrite(header, 1, sizeof(header), writer->fp) == sizeof(header);
+        }
+        if (ferror(writer->fp))
+                success = 0;
+        if (fclose(writer->fp))
+                success = 0;
+        free(writer->buffer);
+        free(writer);
+        return success;
+}
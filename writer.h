@@ -0,0 +1,90 @@
+// Include Guards
+#ifndef WRITER_H
+#define WRITER_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threadpool.h"
+
+// Ausgabeformate. IMAGE_FORMAT_AUTO wählt BMP, solange das Bild in dessen 32 Bit
+// Größenfelder passt, und sonst BigTIFF mit 64 Bit Offsets. BMP8, RLE8 und PNG
+// speichern je Pixel nur den Index seiner Farbe in einer Farbtabelle. RLE8 fasst
+// zusätzlich Folgen gleicher Pixel zusammen, PNG komprimiert mit Deflate
+typedef enum
+{
+        IMAGE_FORMAT_AUTO,
+        IMAGE_FORMAT_BMP,
+        IMAGE_FORMAT_BIGTIFF,
+        IMAGE_FORMAT_BMP8,
+        IMAGE_FORMAT_RLE8,
+        IMAGE_FORMAT_PNG,
+} image_format;
+
+// Angaben zum Schreiben einer Datei, die über Format und Bildgröße hinausgehen
+typedef struct
+{
+        uint64_t rows_per_strip; // Zeilen pro TIFF Strip
+        const uint32_t *colors;  // Farbtabelle der indizierten Formate (s. palette_colors)
+        unsigned color_count;    // Anzahl der Farben, höchstens 256
+        threadpool *pool;        // Worker für die PNG Kompression (NULL: nur der Aufrufer)
+} image_writer_settings;
+
+// Undurchsichtiger Typ eines zeilenweise schreibenden Bildes (s. writer.c)
+typedef struct image_writer image_writer;
+
+// image_format_parse: Übersetzt den Namen eines Formats ("auto", "bmp", "bigtiff",
+// "bmp8", "rle8", "png"). Gibt 0 zurück, falls der Name unbekannt ist
+_Bool image_format_parse(const char *name, image_format *format);
+
+// image_format_resolve: Ersetzt IMAGE_FORMAT_AUTO durch das passende Format.
+// Gibt IMAGE_FORMAT_AUTO zurück, falls das Bild im gewählten Format nicht
+// darstellbar ist
+image_format image_format_resolve(image_format format, uint64_t width, uint64_t height);
+
+// image_format_extension: Dateiendung eines Formats inklusive Punkt
+const char *image_format_extension(image_format format);
+
+// image_format_rgb: Gibt an, ob die Pixel bzw. die Farbtabelle des Formats in der
+// Reihenfolge Rot, Grün, Blau (BigTIFF, PNG) statt Blau, Grün, Rot (BMP) stehen
+_Bool image_format_rgb(image_format format);
+
+// image_format_indexed: Gibt an, ob das Format je Pixel ein Byte mit dem Index seiner
+// Farbe statt drei Byte Farbe speichert
+_Bool image_format_indexed(image_format format);
+
+// image_writer_open: Erstellt die Datei und schreibt die Header. BMP, BMP8 und
+// BigTIFF werden in ihrer endgültigen Größe angelegt und in den Speicher abgebildet,
+// RLE8 und PNG fortlaufend geschrieben. Gibt NULL zurück, falls die Datei nicht
+// erstellt oder ihr Speicherplatz nicht reserviert werden konnte
+image_writer *image_writer_open(const char *path, image_format format, uint64_t width, uint64_t height,
+                                const image_writer_settings *settings);
+
+// image_writer_open_stream: Wie image_writer_open, schreibt ein fortlaufend
+// geschriebenes Format (RLE8, PNG) aber in den geöffneten Datenstrom fp, z.B. von
+// open_memstream. Der Writer übernimmt fp und schließt ihn in image_writer_close.
+// Gibt NULL zurück, falls das Format abgebildet wird oder die Header nicht
+// geschrieben werden konnten. fp bleibt dann geöffnet
+image_writer *image_writer_open_stream(FILE *fp, image_format format, uint64_t width, uint64_t height,
+                                       const image_writer_settings *settings);
+
+// image_writer_bottom_up: Gibt an, ob die Datei mit der untersten Zeile (Zeile 0,
+// i_start) beginnt. Werden die Zeilen in dieser Reihenfolge gefüllt, wird die Datei
+// von vorne nach hinten geschrieben
+_Bool image_writer_bottom_up(const image_writer *writer);
+
+// image_writer_rows: Gibt einen Pointer auf die Pixel der Bildzeile y (Zeile 0 liegt
+// bei i_start) zurück, bei abgebildeten Formaten direkt in der Datei. Die Zeile y + 1
+// liegt *stride Byte danach, bei von oben beginnenden Formaten also davor. Die Pixel
+// werden im Format von image_format_rgb bzw. image_format_indexed dorthin geschrieben.
+// Die Zeilen [y;y+count) gelten damit als geschrieben. RLE8 und PNG Zeilen müssen in
+// der Reihenfolge von image_writer_bottom_up angefordert werden und werden beim
+// nächsten Aufruf bzw. beim Schließen kodiert. Gibt NULL zurück, falls die Zeilen
+// außerhalb des Bildes oder nicht in dieser Reihenfolge liegen oder das Kodieren
+// der vorherigen Zeilen fehlgeschlagen ist
+unsigned char *image_writer_rows(image_writer *writer, uint64_t y, uint64_t count, ptrdiff_t *stride);
+
+// image_writer_close: Kodiert die letzten Zeilen, schließt die Datei und gibt den
+// Writer frei. Gibt 0 zurück, falls nicht alle Zeilen geschrieben wurden
+_Bool image_writer_close(image_writer *writer);
+
+#endif // !WRITER_H